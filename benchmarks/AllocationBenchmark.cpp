@@ -0,0 +1,196 @@
+
+#include "synthetic_mesh.hpp"
+
+#include "gmsh_parser.hpp"
+#include "mesh_reader.hpp"
+#include "monotonic_arena.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace
+{
+/// Number of calls to the global allocation functions
+std::atomic<std::int64_t> allocations{0};
+}
+
+void* operator new(std::size_t const size)
+{
+    ++allocations;
+
+    if (auto const memory = std::malloc(size == 0 ? 1 : size)) return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* const memory) noexcept { std::free(memory); }
+
+void operator delete(void* const memory, std::size_t) noexcept { std::free(memory); }
+
+namespace
+{
+using namespace imr;
+
+/// Construct the elements of each batch as the parser did before the arena,
+/// with heap allocated vectors for the node indices and the tags
+class heap_elements : public gmsh_visitor
+{
+public:
+    void elements(span<element_record const> const batch) override
+    {
+        auto const before = allocations.load();
+
+        for (auto const& record : batch)
+        {
+            element const element_data(std::vector<std::int64_t>(record.node_indices.begin(),
+                                                                 record.node_indices.end()),
+                                       std::vector<std::int32_t>(record.tags.begin(),
+                                                                 record.tags.end()),
+                                       record.type_id,
+                                       record.id);
+        }
+        element_allocations += allocations.load() - before;
+    }
+
+    std::int64_t element_allocations = 0;
+};
+
+/// Construct the elements of each batch in an arena
+class arena_elements : public gmsh_visitor
+{
+public:
+    void elements(span<element_record const> const batch) override
+    {
+        auto const before = allocations.load();
+
+        for (auto const& record : batch)
+        {
+            element const element_data(record.node_indices,
+                                       record.tags,
+                                       record.type_id,
+                                       record.id,
+                                       arena);
+        }
+        arena.reset();
+
+        element_allocations += allocations.load() - before;
+    }
+
+    monotonic_arena arena;
+
+    std::int64_t element_allocations = 0;
+};
+
+/// Return the number of allocations made by the function
+template <typename Function>
+std::int64_t count_allocations(Function&& function)
+{
+    auto const before = allocations.load();
+    function();
+    return allocations.load() - before;
+}
+
+void print(std::string const& name, std::int64_t const count, std::int64_t const elements)
+{
+    std::cout << std::string(2, ' ') << std::left << std::setw(28) << name << std::right
+              << std::setw(12) << count << std::setw(16) << std::fixed << std::setprecision(4)
+              << static_cast<double>(count) / elements << std::defaultfloat << "\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    namespace po = boost::program_options;
+
+    po::options_description options("Options");
+
+    options.add_options()("help", "Print help messages");
+    options.add_options()("cells",
+                          po::value<std::int32_t>()->default_value(32),
+                          "Number of cells along each axis of the unit cube");
+    options.add_options()("partitions",
+                          po::value<std::int32_t>()->default_value(4),
+                          "Number of slab partitions");
+    options.add_options()("tetrahedra", "Split each hexahedron into six tetrahedra");
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << "\nCount the allocations made for each parsed element\n\n"
+                      << options << std::endl;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (po::error& error_message)
+    {
+        std::cerr << "ERROR: " << error_message.what() << "\n\n" << options << std::endl;
+        return 1;
+    }
+
+    synthetic_mesh mesh;
+    mesh.cells      = vm["cells"].as<std::int32_t>();
+    mesh.partitions = vm["partitions"].as<std::int32_t>();
+    mesh.tetrahedra = vm.count("tetrahedra") > 0;
+
+    std::string const file_name = "synthetic_allocations.msh";
+    mesh.write(file_name);
+
+    auto const elements = mesh.number_of_elements();
+
+    std::cout << "\n"
+              << file_name << ": " << mesh.number_of_nodes() << " nodes, " << elements
+              << " elements, " << mesh.partitions << " partitions\n\n"
+              << std::string(2, ' ') << std::left << std::setw(28) << "Elements" << std::right
+              << std::setw(12) << "Allocations" << std::setw(16) << "Per element"
+              << "\n";
+
+    // Only the allocations made while the elements are constructed are counted
+    heap_elements heap;
+    gmsh_parser().parse(file_name, heap);
+
+    print("heap vectors", heap.element_allocations, elements);
+
+    arena_elements arena;
+    gmsh_parser().parse(file_name, arena);
+
+    print("arena", arena.element_allocations, elements);
+
+    // The reader also builds the element groups, whose vectors grow
+    // geometrically, and the interface node sets
+    std::cout.setstate(std::ios::failbit);
+
+    mesh_reader reader(file_name, NodalOrdering::Local, IndexingBase::Zero, distributed::feti);
+
+    auto const reader_allocations = count_allocations([&]() { reader.mesh(); });
+
+    std::cout.clear();
+
+    // Each interface node is a node of a std::set, which is allocated once
+    // per node rather than once per element
+    std::int64_t interface_allocations = reader.interfaces().size();
+    for (auto const& interface : reader.interfaces())
+    {
+        interface_allocations += interface.second.size();
+    }
+
+    print("mesh_reader (arena)", reader_allocations, elements);
+    print("  interface node sets", interface_allocations, elements);
+    print("  groups and parser buffers", reader_allocations - interface_allocations, elements);
+
+    std::remove(file_name.c_str());
+
+    return 0;
+}
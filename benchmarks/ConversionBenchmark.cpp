@@ -0,0 +1,173 @@
+
+#include "synthetic_mesh.hpp"
+
+#include "mesh_reader.hpp"
+#include "phase_timer.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+/// Print the minimum, median, mean and standard deviation of the samples
+void print_statistics(std::string const& name, std::vector<double> samples)
+{
+    std::sort(begin(samples), end(samples));
+
+    auto const size   = static_cast<double>(samples.size());
+    auto const mean   = std::accumulate(begin(samples), end(samples), 0.0) / size;
+    auto const median = samples.size() % 2 == 1
+                            ? samples[samples.size() / 2]
+                            : 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+
+    auto variance = 0.0;
+    for (auto const sample : samples) variance += (sample - mean) * (sample - mean);
+
+    auto const deviation = samples.size() > 1 ? std::sqrt(variance / (size - 1.0)) : 0.0;
+
+    std::cout << std::string(2, ' ') << std::left << std::setw(20) << name << std::right
+              << std::fixed << std::setprecision(6) << std::setw(12) << samples.front()
+              << std::setw(12) << median << std::setw(12) << mean << std::setw(12) << deviation
+              << std::defaultfloat << "\n";
+}
+
+/// Return the total time of the phases with the given name
+double phase_seconds(std::vector<imr::phase_timing> const& timings, std::string const& name)
+{
+    auto seconds = 0.0;
+    for (auto const& timing : timings)
+    {
+        auto const phase = timing.phase.substr(timing.phase.find_last_of('/') + 1);
+        if (phase == name) seconds += timing.seconds;
+    }
+    return seconds;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace imr;
+
+    namespace po = boost::program_options;
+
+    po::options_description options("Options");
+
+    options.add_options()("help", "Print help messages");
+    options.add_options()("cells",
+                          po::value<std::int32_t>()->default_value(32),
+                          "Number of cells along each axis of the unit cube");
+    options.add_options()("partitions",
+                          po::value<std::int32_t>()->default_value(4),
+                          "Number of slab partitions");
+    options.add_options()("tetrahedra", "Split each hexahedron into six tetrahedra");
+    options.add_options()("repetitions",
+                          po::value<int>()->default_value(5),
+                          "Number of timed repetitions of each benchmark");
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << "\nTime the conversion of synthetic structured meshes\n\n"
+                      << options << std::endl;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (po::error& error_message)
+    {
+        std::cerr << "ERROR: " << error_message.what() << "\n\n" << options << std::endl;
+        return 1;
+    }
+
+    auto const repetitions = std::max(vm["repetitions"].as<int>(), 1);
+
+    for (auto const binary : {false, true})
+    {
+        synthetic_mesh mesh;
+        mesh.cells      = vm["cells"].as<std::int32_t>();
+        mesh.partitions = vm["partitions"].as<std::int32_t>();
+        mesh.tetrahedra = vm.count("tetrahedra") > 0;
+        mesh.binary     = binary;
+
+        std::string const file_name = std::string("synthetic_") +
+                                      (mesh.tetrahedra ? "tet" : "hex") +
+                                      (binary ? "_binary" : "_ascii") + ".msh";
+        mesh.write(file_name);
+
+        std::cout << "\n"
+                  << file_name << ": " << mesh.number_of_nodes() << " nodes, "
+                  << mesh.number_of_elements() << " elements, " << mesh.partitions
+                  << " partitions\n\n";
+
+        std::map<std::string, std::vector<double>> samples;
+
+        for (auto repetition = 0; repetition < repetitions; ++repetition)
+        {
+            // The progress messages of the reader are not of interest
+            std::cout.setstate(std::ios::failbit);
+
+            reset_timers();
+            enable_timers();
+
+            auto const start = std::chrono::steady_clock::now();
+
+            mesh_reader reader(file_name,
+                               NodalOrdering::Local,
+                               IndexingBase::Zero,
+                               distributed::feti);
+            reader.nodes();
+            reader.mesh();
+
+            auto const parsed = std::chrono::steady_clock::now();
+
+            reader.write(false);
+
+            auto const written = std::chrono::steady_clock::now();
+
+            enable_timers(false);
+
+            std::cout.clear();
+
+            auto const timings = recorded_timings();
+
+            samples["parse"].push_back(std::chrono::duration<double>(parsed - start).count());
+            samples["partition write"].push_back(
+                std::chrono::duration<double>(written - parsed).count());
+            samples["serialise"].push_back(phase_seconds(timings, "serialise"));
+            samples["file write"].push_back(phase_seconds(timings, "file write"));
+        }
+
+        std::cout << std::string(2, ' ') << std::left << std::setw(20) << "Seconds" << std::right
+                  << std::setw(12) << "Minimum" << std::setw(12) << "Median" << std::setw(12)
+                  << "Mean" << std::setw(12) << "Deviation"
+                  << "\n";
+
+        for (auto const name : {"parse", "partition write", "serialise", "file write"})
+        {
+            print_statistics(name, samples[name]);
+        }
+
+        std::remove(file_name.c_str());
+        for (auto partition = 0; partition < mesh.partitions; ++partition)
+        {
+            auto const stem = file_name.substr(0, file_name.find_last_of('.'));
+            std::remove((stem + ".mesh" + (mesh.partitions > 1 ? std::to_string(partition) : ""))
+                            .c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+
+#include "synthetic_mesh.hpp"
+
+#include "element_type.hpp"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace imr
+{
+namespace
+{
+/// Splitting of a hexahedron into six tetrahedra around the diagonal 0-6
+constexpr std::array<std::array<int, 4>, 6> hexahedron_tetrahedra{{{{0, 1, 2, 6}},
+                                                                    {{0, 2, 3, 6}},
+                                                                    {{0, 3, 7, 6}},
+                                                                    {{0, 7, 4, 6}},
+                                                                    {{0, 4, 5, 6}},
+                                                                    {{0, 5, 1, 6}}}};
+
+/// Element to be written with its tags and nodes
+struct element_entry
+{
+    std::int32_t id;
+    std::int32_t type;
+    std::vector<std::int32_t> tags;
+    std::vector<std::int32_t> nodes;
+};
+
+/// Writes the entries in either format, grouping the consecutive binary
+/// entries with the same type and number of tags into a block
+class element_writer
+{
+public:
+    element_writer(std::ofstream& file, bool const binary) : file(file), binary(binary) {}
+
+    ~element_writer() { flush(); }
+
+    void write(element_entry const& entry)
+    {
+        if (!binary)
+        {
+            file << entry.id << " " << entry.type << " " << entry.tags.size();
+            for (auto const tag : entry.tags) file << " " << tag;
+            for (auto const node : entry.nodes) file << " " << node;
+            file << "\n";
+            return;
+        }
+
+        if (block_size > 0 && (block_type != entry.type || block_tags != entry.tags.size()))
+        {
+            flush();
+        }
+        block_type = entry.type;
+        block_tags = entry.tags.size();
+        ++block_size;
+
+        append(&entry.id, 1);
+        append(entry.tags.data(), entry.tags.size());
+        append(entry.nodes.data(), entry.nodes.size());
+    }
+
+    void flush()
+    {
+        if (block_size == 0) return;
+
+        std::int32_t const header[3] = {block_type,
+                                        static_cast<std::int32_t>(block_size),
+                                        static_cast<std::int32_t>(block_tags)};
+
+        file.write(reinterpret_cast<char const*>(header), sizeof(header));
+        file.write(block.data(), block.size());
+
+        block.clear();
+        block_size = 0;
+    }
+
+private:
+    void append(std::int32_t const* data, std::size_t const size)
+    {
+        auto const bytes = reinterpret_cast<char const*>(data);
+        block.insert(end(block), bytes, bytes + size * sizeof(std::int32_t));
+    }
+
+private:
+    std::ofstream& file;
+    bool binary;
+
+    /// Records of the current binary block
+    std::vector<char> block;
+    std::int32_t block_type = 0;
+    std::size_t block_tags = 0, block_size = 0;
+};
+}
+
+std::int64_t synthetic_mesh::number_of_nodes() const noexcept
+{
+    return std::int64_t(cells + 1) * (cells + 1) * (cells + 1);
+}
+
+std::int64_t synthetic_mesh::number_of_elements() const noexcept
+{
+    auto const faces = std::int64_t(cells) * cells;
+    return tetrahedra ? 6 * faces * cells + 2 * faces : faces * cells + faces;
+}
+
+void synthetic_mesh::write(std::string const& file_name) const
+{
+    if (cells < 1 || partitions < 1 || partitions > cells)
+    {
+        throw std::domain_error("The mesh needs at least one cell per partition");
+    }
+
+    std::ofstream file(file_name, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::domain_error("Output file " + file_name + " was not able to be opened");
+    }
+
+    file.precision(17);
+
+    file << "$MeshFormat\n2.2 " << (binary ? 1 : 0) << " 8\n";
+    if (binary)
+    {
+        std::int32_t const one = 1;
+        file.write(reinterpret_cast<char const*>(&one), sizeof(one));
+        file << "\n";
+    }
+    file << "$EndMeshFormat\n";
+
+    file << "$PhysicalNames\n2\n2 1 \"left_boundary\"\n3 2 \"domain\"\n$EndPhysicalNames\n";
+
+    auto const n = cells + 1;
+
+    auto const node_id = [n](std::int32_t const i, std::int32_t const j, std::int32_t const k) {
+        return 1 + i + n * (j + n * k);
+    };
+
+    file << "$Nodes\n" << number_of_nodes() << "\n";
+
+    for (std::int32_t k = 0; k < n; ++k)
+    {
+        for (std::int32_t j = 0; j < n; ++j)
+        {
+            for (std::int32_t i = 0; i < n; ++i)
+            {
+                std::int32_t const id = node_id(i, j, k);
+
+                double const coordinates[3] = {double(i) / cells,
+                                               double(j) / cells,
+                                               double(k) / cells};
+
+                if (binary)
+                {
+                    file.write(reinterpret_cast<char const*>(&id), sizeof(id));
+                    file.write(reinterpret_cast<char const*>(coordinates), sizeof(coordinates));
+                }
+                else
+                {
+                    file << id << " " << coordinates[0] << " " << coordinates[1] << " "
+                         << coordinates[2] << "\n";
+                }
+            }
+        }
+    }
+    if (binary) file << "\n";
+    file << "$EndNodes\n";
+
+    file << "$Elements\n" << number_of_elements() << "\n";
+    {
+        element_writer writer(file, binary);
+
+        std::int32_t id = 1;
+
+        // Slab partition (one based) of the cells at x index i
+        auto const partition = [&](std::int32_t const i) { return 1 + i * partitions / cells; };
+
+        auto const tags = [&](std::int32_t const physical, std::int32_t const i) {
+            std::vector<std::int32_t> element_tags{physical, physical};
+
+            if (partitions == 1) return element_tags;
+
+            auto const owner = partition(i);
+
+            std::vector<std::int32_t> ghosts;
+            if (i > 0 && partition(i - 1) != owner) ghosts.push_back(-partition(i - 1));
+            if (i + 1 < cells && partition(i + 1) != owner) ghosts.push_back(-partition(i + 1));
+
+            element_tags.push_back(1 + ghosts.size());
+            element_tags.push_back(owner);
+            element_tags.insert(end(element_tags), begin(ghosts), end(ghosts));
+
+            return element_tags;
+        };
+
+        // Boundary faces on x = 0
+        for (std::int32_t k = 0; k < cells; ++k)
+        {
+            for (std::int32_t j = 0; j < cells; ++j)
+            {
+                std::vector<std::int32_t> const face{node_id(0, j, k),
+                                                     node_id(0, j, k + 1),
+                                                     node_id(0, j + 1, k + 1),
+                                                     node_id(0, j + 1, k)};
+                if (tetrahedra)
+                {
+                    writer.write({id++, TRIANGLE3, tags(1, 0), {face[0], face[1], face[2]}});
+                    writer.write({id++, TRIANGLE3, tags(1, 0), {face[0], face[2], face[3]}});
+                }
+                else
+                {
+                    writer.write({id++, QUADRILATERAL4, tags(1, 0), face});
+                }
+            }
+        }
+
+        // Volume elements ordered by slab
+        for (std::int32_t i = 0; i < cells; ++i)
+        {
+            for (std::int32_t k = 0; k < cells; ++k)
+            {
+                for (std::int32_t j = 0; j < cells; ++j)
+                {
+                    std::array<std::int32_t, 8> const hexahedron{node_id(i, j, k),
+                                                                 node_id(i + 1, j, k),
+                                                                 node_id(i + 1, j + 1, k),
+                                                                 node_id(i, j + 1, k),
+                                                                 node_id(i, j, k + 1),
+                                                                 node_id(i + 1, j, k + 1),
+                                                                 node_id(i + 1, j + 1, k + 1),
+                                                                 node_id(i, j + 1, k + 1)};
+                    if (tetrahedra)
+                    {
+                        for (auto const& tetrahedron : hexahedron_tetrahedra)
+                        {
+                            std::vector<std::int32_t> nodes;
+                            for (auto const local : tetrahedron)
+                            {
+                                nodes.push_back(hexahedron[local]);
+                            }
+
+                            writer.write({id++, TETRAHEDRON4, tags(2, i), nodes});
+                        }
+                    }
+                    else
+                    {
+                        writer.write({id++,
+                                      HEXAHEDRON8,
+                                      tags(2, i),
+                                      {begin(hexahedron), end(hexahedron)}});
+                    }
+                }
+            }
+        }
+    }
+    if (binary) file << "\n";
+    file << "$EndElements\n";
+}
+} // namespace imr
@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace imr
+{
+/// Description of a structured mesh of the unit cube
+struct synthetic_mesh
+{
+    /// Number of cells along each axis
+    std::int32_t cells = 32;
+    /// Number of slab partitions along the x axis (one for a serial mesh)
+    std::int32_t partitions = 4;
+    /// Split each hexahedron into six tetrahedra
+    bool tetrahedra = false;
+    /// Write the nodes and the elements in the binary format
+    bool binary = false;
+
+    /// Return the number of nodes of the mesh
+    std::int64_t number_of_nodes() const noexcept;
+
+    /// Return the number of volume and boundary elements of the mesh
+    std::int64_t number_of_elements() const noexcept;
+
+    /// Write the mesh as a MSH 2.2 file with a "domain" volume group and a
+    /// "left_boundary" surface group on the x = 0 face.  The volume elements
+    /// are partitioned into slabs along the x axis, where the elements
+    /// touching a neighbouring slab are ghosted into it as Gmsh would.
+    void write(std::string const& file_name) const;
+};
+} // namespace imr
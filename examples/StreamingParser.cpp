@@ -0,0 +1,41 @@
+
+#include "gmsh_parser.hpp"
+
+#include <iostream>
+#include <map>
+
+/// Count the elements in each physical group without storing the mesh
+class physical_group_counter : public imr::gmsh_visitor
+{
+public:
+    void physical_name(std::int32_t const,
+                       std::int32_t const physical_id,
+                       std::string const& name) override
+    {
+        names[physical_id] = name;
+    }
+
+    void elements(imr::span<imr::element_record const> const batch) override
+    {
+        for (auto const& record : batch)
+        {
+            ++counts[names[record.tags[0]]];
+        }
+    }
+
+    std::map<std::int32_t, std::string> names;
+    std::map<std::string, std::int64_t> counts;
+};
+
+int main()
+{
+    physical_group_counter counter;
+
+    imr::gmsh_parser().parse("basic.msh", counter);
+
+    for (auto const& count : counter.counts)
+    {
+        std::cout << count.first << " has " << count.second << " elements\n";
+    }
+    std::cout << "Done!\n";
+}
@@ -0,0 +1,157 @@
+
+#include "batch_scheduler.hpp"
+
+#include "log.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+namespace imr
+{
+namespace
+{
+std::size_t file_size(std::string const& file_name)
+{
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<std::size_t>(file.tellg()) : 0;
+}
+}
+
+batch_scheduler::batch_scheduler(std::size_t const memory_budget, unsigned const threads)
+    : m_memory_budget(memory_budget), m_threads(std::max(1u, threads))
+{
+}
+
+std::size_t batch_scheduler::memory_estimate(std::size_t const file_size) noexcept
+{
+    // The nodes and elements take roughly the size of the text they are
+    // parsed from, while the JSON document of a partition is several times
+    // larger than the elements it holds
+    return 8 * file_size;
+}
+
+void batch_scheduler::run(std::vector<std::string> const& input_files,
+                          task const& convert,
+                          std::ostream& log) const
+{
+    auto const count = input_files.size();
+
+    std::vector<std::size_t> sizes(count);
+    std::transform(begin(input_files), end(input_files), begin(sizes), file_size);
+
+    auto const total_size = std::max<std::size_t>(std::accumulate(begin(sizes), end(sizes),
+                                                                  std::size_t{0}),
+                                                  1);
+
+    // Start the largest conversions first to pack the smaller ones around them
+    std::vector<std::size_t> pending(count);
+    std::iota(begin(pending), end(pending), 0);
+    std::stable_sort(begin(pending), end(pending), [&](auto const left, auto const right) {
+        return sizes[left] > sizes[right];
+    });
+
+    std::vector<std::string> logs(count);
+    std::vector<bool> finished(count, false);
+    std::vector<std::exception_ptr> errors(count);
+
+    std::mutex mutex;
+    std::condition_variable released;
+
+    std::size_t free_memory = m_memory_budget;
+    unsigned free_threads   = m_threads;
+    unsigned running        = 0;
+    std::size_t next_log    = 0;
+
+    auto const threads_for = [&](std::size_t const i) {
+        auto const share = static_cast<unsigned>(m_threads * sizes[i] / total_size);
+        return std::min(std::max(share, 1u), m_threads);
+    };
+
+    auto const worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!pending.empty())
+        {
+            // Take the largest pending conversion fitting the free resources,
+            // or the largest if nothing is running to guarantee progress
+            auto const fits = std::find_if(begin(pending), end(pending), [&](auto const i) {
+                return memory_estimate(sizes[i]) <= free_memory && threads_for(i) <= free_threads;
+            });
+
+            if (fits == end(pending) && running > 0)
+            {
+                released.wait(lock);
+                continue;
+            }
+
+            auto const selected = fits == end(pending) ? begin(pending) : fits;
+            auto const i        = *selected;
+            pending.erase(selected);
+
+            auto const memory  = std::min(memory_estimate(sizes[i]), free_memory);
+            auto const threads = std::min(threads_for(i), std::max(free_threads, 1u));
+
+            free_memory -= memory;
+            free_threads -= std::min(threads, free_threads);
+            ++running;
+
+            lock.unlock();
+            {
+                // A single conversion is logged as it progresses
+                std::ostringstream file_log;
+                scoped_log const redirect(count == 1 ? log : file_log);
+
+                auto const previous_limit = thread_limit();
+                thread_limit()            = threads;
+
+                try
+                {
+                    convert(input_files[i], memory);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+                thread_limit() = previous_limit;
+
+                logs[i] = file_log.str();
+            }
+            lock.lock();
+
+            free_memory += memory;
+            free_threads = std::min(free_threads + threads, m_threads);
+            --running;
+
+            // Write out the logs of the conversions finished in input order
+            finished[i] = true;
+            for (; next_log < count && finished[next_log]; ++next_log)
+            {
+                log << logs[next_log] << std::flush;
+                logs[next_log].clear();
+            }
+            released.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min<std::size_t>(m_threads, count); ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : pool) thread.join();
+
+    for (auto const& error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+}
+} // namespace imr
@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace imr
+{
+/// batch_scheduler converts multiple input files concurrently on a shared
+/// pool of threads.  The conversions are started largest file first, each
+/// reserving an estimate of its memory use from a global memory budget and a
+/// share of the threads proportional to its file size, so large files get
+/// more threads for the parallel algorithms and small files are packed
+/// together.  A conversion which does not fit the remaining budget waits
+/// until enough is released, unless nothing else is running.
+///
+/// The progress messages of each conversion are buffered \sa scoped_log and
+/// written out in the order of the input files, so the output does not
+/// depend on the scheduling.
+class batch_scheduler
+{
+public:
+    /// Conversion of an input file given the number of bytes reserved for it
+    using task = std::function<void(std::string const& input_file, std::size_t const memory)>;
+
+public:
+    /// \param memory_budget Bytes shared by the concurrent conversions
+    /// \param threads Number of threads shared by the conversions
+    explicit batch_scheduler(std::size_t const memory_budget, unsigned const threads);
+
+    /// Return the estimated number of bytes held in memory while converting
+    /// a gmsh file of the given size, including the JSON output
+    static std::size_t memory_estimate(std::size_t const file_size) noexcept;
+
+    /// Call convert for each of the input files and write the progress
+    /// messages of each file to the log once its conversion has finished.
+    /// The first exception thrown (in the order of the input files) is
+    /// rethrown once all of the conversions have finished.
+    void run(std::vector<std::string> const& input_files,
+             task const& convert,
+             std::ostream& log) const;
+
+private:
+    std::size_t m_memory_budget;
+    unsigned m_threads;
+};
+} // namespace imr
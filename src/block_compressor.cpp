@@ -0,0 +1,140 @@
+#include "block_compressor.hpp"
+
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef IMR_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace imr
+{
+namespace
+{
+/// \return the block compressed into a complete gzip member
+std::string gzip_block(std::string const& block)
+{
+#ifdef IMR_WITH_ZLIB
+    z_stream stream{};
+
+    // Sixteen is added to the window bits for a gzip header, whose
+    // modification time is zero so the output only depends on the input
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+        Z_OK)
+    {
+        throw std::runtime_error("The gzip compression could not be initialised");
+    }
+
+    std::string compressed(deflateBound(&stream, block.size()), '\0');
+
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(block.data()));
+    stream.avail_in  = static_cast<uInt>(block.size());
+    stream.next_out  = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_out = static_cast<uInt>(compressed.size());
+
+    auto const status = deflate(&stream, Z_FINISH);
+
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) throw std::runtime_error("The gzip compression failed");
+
+    return compressed;
+#else
+    return block;
+#endif
+}
+}
+
+bool compression_available(compression const method) noexcept
+{
+    switch (method)
+    {
+        case compression::none: return true;
+        case compression::gzip:
+#ifdef IMR_WITH_ZLIB
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+char const* compression_suffix(compression const method) noexcept
+{
+    return method == compression::gzip ? ".gz" : "";
+}
+
+block_compressor::block_compressor(compression const method,
+                                   sink output,
+                                   std::size_t const block_size)
+    : m_method(method),
+      m_output(std::move(output)),
+      m_block_size(std::max(block_size, std::size_t{1})),
+      m_max_pending(available_threads())
+{
+    if (m_method == compression::none || !compression_available(m_method))
+    {
+        throw std::domain_error("The compression method is not available");
+    }
+    m_block.reserve(m_block_size);
+}
+
+void block_compressor::write(char const* data, std::size_t size)
+{
+    while (size > 0)
+    {
+        auto const count = std::min(size, m_block_size - m_block.size());
+
+        m_block.append(data, count);
+        data += count;
+        size -= count;
+
+        if (m_block.size() == m_block_size) submit();
+    }
+}
+
+void block_compressor::finish()
+{
+    // An empty stream is written as an empty member so the file stays valid
+    if (!m_block.empty() || m_blocks == 0) submit();
+
+    while (!m_pending.empty()) flush_oldest();
+}
+
+void block_compressor::submit()
+{
+    // Bound the memory held by the blocks in flight
+    if (m_pending.size() >= m_max_pending) flush_oldest();
+
+    m_pending.push_back(std::async(std::launch::async, gzip_block, std::move(m_block)));
+
+    m_block.clear();
+    m_block.reserve(m_block_size);
+
+    ++m_blocks;
+}
+
+void block_compressor::flush_oldest()
+{
+    auto const block = m_pending.front().get();
+    m_pending.pop_front();
+
+    m_output(block);
+}
+
+std::string compress(std::string const& data, compression const method)
+{
+    std::string compressed;
+
+    block_compressor compressor(method,
+                                [&](std::string const& block) { compressed += block; });
+    compressor.write(data);
+    compressor.finish();
+
+    return compressed;
+}
+} // namespace imr
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "output_format.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+
+namespace imr
+{
+/// \return true if imr was built with the library of the compression method
+bool compression_available(compression const method) noexcept;
+
+/// \return the suffix appended to the name of a compressed file, e.g. ".gz"
+char const* compression_suffix(compression const method) noexcept;
+
+/// block_compressor is a streaming compression stage which cuts the data into
+/// blocks and compresses each block independently on the available threads.
+/// The compressed blocks are passed to the sink in order as soon as they are
+/// ready, so the sink (e.g. a file) is written while the following blocks are
+/// compressed.  Each gzip block is a complete gzip member, and a sequence of
+/// members is a valid gzip file for gzip, zcat and zlib.  The output does not
+/// depend on the number of threads.
+class block_compressor
+{
+public:
+    using sink = std::function<void(std::string const&)>;
+
+    /// \param block_size Uncompressed bytes of each block
+    /// \throw std::domain_error if the compression method is not available
+    block_compressor(compression const method,
+                     sink output,
+                     std::size_t const block_size = std::size_t{1} << 20);
+
+    void write(char const* data, std::size_t size);
+
+    void write(std::string const& data) { write(data.data(), data.size()); }
+
+    /// Compress the remaining data and pass every block to the sink
+    void finish();
+
+private:
+    /// Start the compression of the current block
+    void submit();
+
+    /// Pass the oldest compressed block to the sink
+    void flush_oldest();
+
+private:
+    compression m_method;
+    sink m_output;
+    std::size_t m_block_size;
+
+    std::string m_block;
+
+    /// Blocks being compressed in file order
+    std::deque<std::future<std::string>> m_pending;
+
+    std::size_t m_max_pending;
+    std::size_t m_blocks = 0;
+};
+
+/// \return the data compressed into blocks \sa block_compressor
+std::string compress(std::string const& data, compression const method);
+} // namespace imr
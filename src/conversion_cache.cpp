@@ -0,0 +1,207 @@
+
+#include "conversion_cache.hpp"
+
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <json/json.h>
+
+namespace imr
+{
+namespace
+{
+constexpr std::uint64_t prime_1 = 0x9e3779b185ebca87ull;
+constexpr std::uint64_t prime_2 = 0xc2b2ae3d27d4eb4full;
+
+constexpr std::uint64_t rotate_left(std::uint64_t const value, int const bits) noexcept
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+std::string to_hex(std::uint64_t const value)
+{
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << value;
+    return stream.str();
+}
+
+/// Return the size of a file or -1 if it does not exist
+std::int64_t file_size(std::string const& file_name)
+{
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<std::int64_t>(file.tellg()) : -1;
+}
+}
+
+void content_hash::update(char const* data, std::size_t size) noexcept
+{
+    m_length += size;
+
+    if (m_pending_size > 0)
+    {
+        auto const count = std::min(size, sizeof(m_pending) - m_pending_size);
+
+        std::memcpy(m_pending + m_pending_size, data, count);
+
+        m_pending_size += count;
+        data += count;
+        size -= count;
+
+        if (m_pending_size < sizeof(m_pending)) return;
+
+        std::uint64_t word;
+        std::memcpy(&word, m_pending, sizeof(word));
+        mix(word);
+
+        m_pending_size = 0;
+    }
+
+    for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        mix(word);
+
+        data += sizeof(std::uint64_t);
+    }
+
+    std::memcpy(m_pending, data, size);
+    m_pending_size = size;
+}
+
+std::uint64_t content_hash::digest() const noexcept
+{
+    auto hash = m_state ^ (m_length * prime_1);
+
+    for (std::size_t i = 0; i < m_pending_size; ++i)
+    {
+        hash = rotate_left(hash ^ (static_cast<unsigned char>(m_pending[i]) * prime_2), 11) *
+               prime_1;
+    }
+
+    // Avalanche the remaining bits
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+    hash *= prime_1;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+void content_hash::mix(std::uint64_t const word) noexcept
+{
+    m_state = rotate_left(m_state ^ (word * prime_2), 31) * prime_1;
+}
+
+std::uint64_t hash_file(std::string const& file_name)
+{
+    std::ifstream file(file_name, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::domain_error("Input file " + file_name + " was not able to be opened");
+    }
+
+    content_hash hash;
+
+    std::vector<char> block(1 << 20);
+
+    while (file.read(block.data(), block.size()) || file.gcount() > 0)
+    {
+        hash.update(block.data(), file.gcount());
+    }
+    return hash.digest();
+}
+
+conversion_cache::conversion_cache(std::string const& input_file_name,
+                                   std::string const& options)
+    : m_manifest_name(input_file_name.substr(0, input_file_name.find_last_of('.')) +
+                      ".manifest.json")
+{
+    content_hash options_hash;
+    options_hash.update(options);
+
+    m_key = to_hex(hash_file(input_file_name)) + to_hex(options_hash.digest());
+
+    std::ifstream manifest_file(m_manifest_name);
+
+    Json::Value manifest;
+
+    if (!manifest_file.is_open() || !Json::Reader().parse(manifest_file, manifest, false))
+    {
+        return;
+    }
+
+    m_previous_key = manifest["Key"].asString();
+
+    auto const& outputs = manifest["Outputs"];
+
+    for (auto const& name : outputs.getMemberNames())
+    {
+        m_previous_outputs[name] = {outputs[name]["Hash"].asString(),
+                                    outputs[name]["Size"].asUInt64()};
+    }
+}
+
+bool conversion_cache::up_to_date() const
+{
+    if (m_previous_key != m_key || m_previous_outputs.empty()) return false;
+
+    for (auto const& output : m_previous_outputs)
+    {
+        if (file_size(output.first) != static_cast<std::int64_t>(output.second.size))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool conversion_cache::write(std::string const& file_name, std::string const& content)
+{
+    content_hash hash;
+    hash.update(content);
+
+    auto& recorded = m_outputs[file_name] = {to_hex(hash.digest()), content.size()};
+
+    auto const previous = m_previous_outputs.find(file_name);
+
+    if (previous != end(m_previous_outputs) && previous->second.hash == recorded.hash &&
+        file_size(file_name) == static_cast<std::int64_t>(recorded.size))
+    {
+        return false;
+    }
+
+    std::ofstream writer(file_name);
+    writer << content;
+
+    return true;
+}
+
+void conversion_cache::save() const
+{
+    Json::Value manifest;
+
+    manifest["Key"] = m_key;
+
+    auto& outputs = manifest["Outputs"];
+
+    for (auto const& output : m_outputs)
+    {
+        outputs[output.first]["Hash"] = output.second.hash;
+        outputs[output.first]["Size"] = Json::UInt64(output.second.size);
+    }
+
+    std::ofstream writer(m_manifest_name);
+
+    writer << json_writer().write(manifest);
+}
+} // namespace imr
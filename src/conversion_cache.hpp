@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace imr
+{
+/// content_hash is a fast non-cryptographic 64 bit hash of a byte stream,
+/// processing eight bytes at a time.  The digest does not depend on how the
+/// stream is split into the calls to update.
+class content_hash
+{
+public:
+    void update(char const* data, std::size_t const size) noexcept;
+
+    void update(std::string const& data) noexcept { update(data.data(), data.size()); }
+
+    std::uint64_t digest() const noexcept;
+
+private:
+    void mix(std::uint64_t const word) noexcept;
+
+private:
+    std::uint64_t m_state = 0x9e3779b97f4a7c15ull;
+    std::uint64_t m_length = 0;
+    /// Bytes which do not fill a word yet
+    char m_pending[8];
+    std::size_t m_pending_size = 0;
+};
+
+/// Return the hash of the contents of a file
+std::uint64_t hash_file(std::string const& file_name);
+
+/// conversion_cache records the hash of an input file and of the conversion
+/// options in a manifest ("filename.manifest.json") next to the outputs,
+/// together with the hash and size of each output file.  A conversion can be
+/// skipped when the manifest matches, and otherwise only the output files
+/// whose content changed are rewritten.
+class conversion_cache
+{
+public:
+    /// Load the manifest of the input file, if any, and hash the input file
+    /// \param options Description of every option affecting the outputs
+    explicit conversion_cache(std::string const& input_file_name, std::string const& options);
+
+    /// Return true if the manifest records the same input and options and
+    /// each of the output files it lists is unchanged in size
+    bool up_to_date() const;
+
+    /// Write the content to the output file unless the manifest records the
+    /// same content for it
+    /// \return true if the file was written
+    bool write(std::string const& file_name, std::string const& content);
+
+    /// Write the manifest for the outputs written (or kept) since construction
+    void save() const;
+
+    /// Return the file name of the manifest
+    std::string const& manifest_name() const noexcept { return m_manifest_name; }
+
+private:
+    struct output
+    {
+        std::string hash;
+        std::uint64_t size;
+    };
+
+private:
+    std::string m_manifest_name;
+
+    /// Hash of the input file and of the options
+    std::string m_key;
+
+    /// Key and outputs recorded in the existing manifest
+    std::string m_previous_key;
+    std::map<std::string, output> m_previous_outputs;
+
+    std::map<std::string, output> m_outputs;
+};
+} // namespace imr
@@ -1,17 +1,38 @@
 
 #include "element.hpp"
 
+#include "element_traits.hpp"
+
 #include <algorithm>
 #include <numeric>
 #include <stdexcept>
+#include <string>
 
 namespace imr
 {
-element::element(std::vector<std::int64_t> node_indices,
-                 std::vector<std::int32_t> tags,
+element::element(std::vector<std::int64_t> const& node_indices,
+                 std::vector<std::int32_t> const& tags,
                  int const typeId,
                  int const id)
-    : m_indices(std::move(node_indices)), m_typeId(typeId), m_id(id)
+    : m_indices(begin(node_indices), end(node_indices)), m_typeId(typeId), m_id(id)
+{
+    set_tags({tags.data(), tags.size()});
+}
+
+element::element(span<std::int64_t const> const node_indices,
+                 span<std::int32_t const> const tags,
+                 int const typeId,
+                 int const id,
+                 monotonic_arena& arena)
+    : m_partitionTags(arena),
+      m_indices(node_indices.begin(), node_indices.end(), arena),
+      m_typeId(typeId),
+      m_id(id)
+{
+    set_tags(tags);
+}
+
+void element::set_tags(span<std::int32_t const> const tags)
 {
     if (tags.empty())
     {
@@ -37,13 +58,7 @@ element::element(std::vector<std::int64_t> node_indices,
     if (m_isElementShared)
     {
         // Pull out the ending tags and populate the partitionTags vector
-        auto const shared_between = tags[2];
-        m_partitionTags.reserve(shared_between);
-
-        for (auto i = 2; i < tags.size(); i++)
-        {
-            m_partitionTags.push_back(tags[i]);
-        }
+        m_partitionTags.assign(tags.begin() + 2, tags.end());
 
         m_maxProcessId = std::abs(*std::max_element(begin(m_partitionTags),
                                                     end(m_partitionTags),
@@ -63,4 +78,20 @@ void element::convertToZeroBasedIndexing()
     --m_id;
 }
 
+namespace
+{
+element_traits const& traits(int const elementTypeId)
+{
+    if (!is_supported(elementTypeId))
+    {
+        throw std::domain_error("The elementTypeId " + std::to_string(elementTypeId) +
+                                " is not implemented");
+    }
+    return element_traits_of[elementTypeId];
+}
+}
+
+int nodes_per_element(int const elementTypeId) { return traits(elementTypeId).nodes; }
+
+int element_dimension(int const elementTypeId) { return traits(elementTypeId).dimension; }
 } // namespace imr
@@ -4,6 +4,9 @@
 #include <cstdint>
 #include <vector>
 
+#include "monotonic_arena.hpp"
+#include "span.hpp"
+
 namespace imr
 {
 class element
@@ -11,12 +14,23 @@ class element
 public:
     enum Property { Physical = 0, Geometric };
 
+    using index_vector = std::vector<std::int64_t, arena_allocator<std::int64_t>>;
+    using tag_vector   = std::vector<std::int32_t, arena_allocator<std::int32_t>>;
+
 public:
-    explicit element(std::vector<std::int64_t> node_indices,
-                     std::vector<int> tags,
+    explicit element(std::vector<std::int64_t> const& node_indices,
+                     std::vector<int> const& tags,
                      int const typeId,
                      int const id);
 
+    /// Construct the element with the node indices and the partition tags
+    /// allocated from an arena which outlives the element \sa arena_allocator
+    explicit element(span<std::int64_t const> const node_indices,
+                     span<std::int32_t const> const tags,
+                     int const typeId,
+                     int const id,
+                     monotonic_arena& arena);
+
     int id() const noexcept { return m_id; }
 
     int typeId() const noexcept { return m_typeId; }
@@ -39,18 +53,21 @@ public:
         return m_isElementShared && m_partitionTags[0] > 1;
     }
 
-    std::vector<std::int64_t> const& node_indices() const noexcept { return m_indices; }
+    index_vector const& node_indices() const noexcept { return m_indices; }
 
-    std::vector<std::int64_t>& node_indices() noexcept { return m_indices; }
+    index_vector& node_indices() noexcept { return m_indices; }
 
-    std::vector<int> const& partitionTags() const noexcept { return m_partitionTags; }
+    tag_vector const& partitionTags() const noexcept { return m_partitionTags; }
 
     /// Subtract one from each index
     void convertToZeroBasedIndexing();
 
 private:
-    std::vector<std::int32_t> m_partitionTags;
-    std::vector<std::int64_t> m_indices;
+    void set_tags(span<std::int32_t const> const tags);
+
+private:
+    tag_vector m_partitionTags;
+    index_vector m_indices;
 
     int m_physicalId;
     int m_geometricId;
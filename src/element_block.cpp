@@ -0,0 +1,42 @@
+
+#include "element_block.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace imr
+{
+template <typename Index>
+basic_element_block<Index>::basic_element_block(int const type_id)
+    : m_type_id(type_id), m_stride(nodes_per_element(type_id))
+{
+}
+
+template <typename Index>
+void basic_element_block<Index>::push_back(element const& element_data)
+{
+    auto const& node_indices = element_data.node_indices();
+
+    if (node_indices.size() != m_stride)
+    {
+        throw std::domain_error("Element " + std::to_string(element_data.id()) + " has " +
+                                std::to_string(node_indices.size()) + " nodes instead of " +
+                                std::to_string(m_stride));
+    }
+
+    m_ids.push_back(element_data.id());
+
+    // The indices are only narrowed once the node ids are known to fit
+    m_connectivity.insert(end(m_connectivity), begin(node_indices), end(node_indices));
+}
+
+template <typename Index>
+void basic_element_block<Index>::reserve(std::size_t const number_of_elements)
+{
+    m_ids.reserve(number_of_elements);
+    m_connectivity.reserve(number_of_elements * m_stride);
+}
+
+template class basic_element_block<std::int32_t>;
+template class basic_element_block<std::int64_t>;
+} // namespace imr
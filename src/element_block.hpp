@@ -0,0 +1,100 @@
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "element.hpp"
+#include "element_traits.hpp"
+#include "span.hpp"
+
+namespace imr
+{
+/// basic_element_block holds the elements of one type in a group with the
+/// nodal connectivity stored in a single array with a fixed stride of the
+/// number of nodes of the element type.  Element i occupies the indices
+/// [i * stride, (i + 1) * stride), so the renumbering and the serialisation of
+/// a group run over contiguous memory rather than one vector per element.
+/// \tparam Index Integer type of the node indices (std::int32_t or std::int64_t)
+template <typename Index>
+class basic_element_block
+{
+public:
+    using index_type = Index;
+
+public:
+    /// \param type_id gmsh element type of every element in the block
+    explicit basic_element_block(int const type_id);
+
+    /// Append the id and the node indices of an element of the block type
+    void push_back(element const& element_data);
+
+    /// Reserve storage for a number of elements
+    void reserve(std::size_t const number_of_elements);
+
+    int type_id() const noexcept { return m_type_id; }
+
+    /// Number of nodes of each element
+    std::size_t stride() const noexcept { return m_stride; }
+
+    /// Number of elements in the block
+    std::size_t size() const noexcept { return m_ids.size(); }
+
+    bool empty() const noexcept { return m_ids.empty(); }
+
+    /// Element ids in the order the elements were appended
+    span<std::int32_t const> ids() const noexcept { return {m_ids.data(), m_ids.size()}; }
+
+    span<std::int32_t> ids() noexcept { return {m_ids.data(), m_ids.size()}; }
+
+    /// Node indices of every element
+    span<Index const> connectivity() const noexcept
+    {
+        return {m_connectivity.data(), m_connectivity.size()};
+    }
+
+    span<Index> connectivity() noexcept
+    {
+        return {m_connectivity.data(), m_connectivity.size()};
+    }
+
+    /// Node indices of the element at a position in the block
+    span<Index const> operator[](std::size_t const i) const noexcept
+    {
+        return {m_connectivity.data() + i * m_stride, m_stride};
+    }
+
+    /// Connectivity as rows of a compile-time size for the block element type
+    /// \sa visit_element_type
+    template <int ElementTypeId>
+    span<std::array<Index, element_type<ElementTypeId>::nodes> const> rows() const noexcept
+    {
+        using row = std::array<Index, element_type<ElementTypeId>::nodes>;
+
+        static_assert(sizeof(row) == sizeof(Index) * element_type<ElementTypeId>::nodes,
+                      "Rows must be laid out without padding");
+
+        return {reinterpret_cast<row const*>(m_connectivity.data()), size()};
+    }
+
+    /// Return the bytes held by the block including the reserved capacity
+    std::size_t memory_bytes() const noexcept
+    {
+        return sizeof(*this) + m_ids.capacity() * sizeof(std::int32_t) +
+               m_connectivity.capacity() * sizeof(Index);
+    }
+
+private:
+    int m_type_id;
+    std::size_t m_stride;
+
+    std::vector<std::int32_t> m_ids;
+    std::vector<Index> m_connectivity;
+};
+
+extern template class basic_element_block<std::int32_t>;
+extern template class basic_element_block<std::int64_t>;
+
+using element_block = basic_element_block<std::int64_t>;
+} // namespace imr
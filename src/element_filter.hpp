@@ -0,0 +1,59 @@
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <set>
+#include <string>
+
+#include "element_type.hpp"
+#include "span.hpp"
+
+namespace imr
+{
+/// element_filter selects the elements to keep while parsing a mesh, so the
+/// elements which are not selected are never stored.  An empty selection
+/// keeps the elements of every physical group or dimension.  The partition
+/// range selects the partitions which are written out.
+struct element_filter
+{
+    /// Names of the physical groups to keep
+    std::set<std::string> physical_names;
+
+    /// Topological dimensions of the elements to keep \sa element_dimension
+    std::set<int> dimensions;
+
+    /// Zero based and inclusive range of the partitions to keep
+    std::int32_t first_partition = 0;
+    std::int32_t last_partition  = std::numeric_limits<std::int32_t>::max();
+
+    /// \return true if every element is kept
+    bool empty() const noexcept
+    {
+        return physical_names.empty() && dimensions.empty() && first_partition == 0 &&
+               last_partition == std::numeric_limits<std::int32_t>::max();
+    }
+
+    /// \return true if the zero based partition is in the partition range
+    bool keep(std::int32_t const partition) const noexcept
+    {
+        return first_partition <= partition && partition <= last_partition;
+    }
+
+    /// \return true if the owner of an element is in the partition range
+    /// \param tags Gmsh element tags \sa element
+    bool keep_owner(span<std::int32_t const> const tags) const noexcept
+    {
+        // Elements of a mesh without partitions belong to the first partition
+        return keep(tags.size() > 3 ? std::abs(tags[3]) - 1 : 0);
+    }
+
+    /// \return true if an element of the physical group and type is kept
+    bool keep(std::string const& physical_name, int const element_type_id) const
+    {
+        return (physical_names.empty() || physical_names.count(physical_name) > 0) &&
+               (dimensions.empty() || dimensions.count(element_dimension(element_type_id)) > 0);
+    }
+};
+} // namespace imr
@@ -0,0 +1,232 @@
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "element_type.hpp"
+
+namespace imr
+{
+/// Local vertex numbering of the edges and faces of an element shape in the
+/// Gmsh ordering.  Faces with three vertices are padded with -1.
+struct element_shape
+{
+    int edges;
+    int faces;
+    int const (*edge_vertices)[2];
+    int const (*face_vertices)[4];
+};
+
+namespace shape
+{
+constexpr int line_edges[][2] = {{0, 1}};
+
+constexpr int triangle_edges[][2] = {{0, 1}, {1, 2}, {2, 0}};
+constexpr int triangle_faces[][4] = {{0, 1, 2, -1}};
+
+constexpr int quadrilateral_edges[][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}};
+constexpr int quadrilateral_faces[][4] = {{0, 1, 2, 3}};
+
+constexpr int tetrahedron_edges[][2] = {{0, 1}, {1, 2}, {2, 0}, {3, 0}, {3, 2}, {3, 1}};
+constexpr int tetrahedron_faces[][4] =
+    {{0, 2, 1, -1}, {0, 1, 3, -1}, {0, 3, 2, -1}, {3, 1, 2, -1}};
+
+constexpr int hexahedron_edges[][2] = {{0, 1},
+                                       {0, 3},
+                                       {0, 4},
+                                       {1, 2},
+                                       {1, 5},
+                                       {2, 3},
+                                       {2, 6},
+                                       {3, 7},
+                                       {4, 5},
+                                       {4, 7},
+                                       {5, 6},
+                                       {6, 7}};
+constexpr int hexahedron_faces[][4] = {{0, 3, 2, 1},
+                                       {0, 1, 5, 4},
+                                       {0, 4, 7, 3},
+                                       {1, 2, 6, 5},
+                                       {2, 3, 7, 6},
+                                       {4, 5, 6, 7}};
+
+constexpr int prism_edges[][2] =
+    {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 4}, {2, 5}, {3, 4}, {3, 5}, {4, 5}};
+constexpr int prism_faces[][4] =
+    {{0, 2, 1, -1}, {3, 4, 5, -1}, {0, 1, 4, 3}, {0, 3, 5, 2}, {1, 2, 5, 4}};
+
+constexpr int pyramid_edges[][2] =
+    {{0, 1}, {0, 3}, {0, 4}, {1, 2}, {1, 4}, {2, 3}, {2, 4}, {3, 4}};
+constexpr int pyramid_faces[][4] =
+    {{0, 1, 4, -1}, {3, 0, 4, -1}, {1, 2, 4, -1}, {2, 3, 4, -1}, {0, 3, 2, 1}};
+
+constexpr element_shape point{0, 0, nullptr, nullptr};
+constexpr element_shape line{1, 0, line_edges, nullptr};
+constexpr element_shape triangle{3, 1, triangle_edges, triangle_faces};
+constexpr element_shape quadrilateral{4, 1, quadrilateral_edges, quadrilateral_faces};
+constexpr element_shape tetrahedron{6, 4, tetrahedron_edges, tetrahedron_faces};
+constexpr element_shape hexahedron{12, 6, hexahedron_edges, hexahedron_faces};
+constexpr element_shape prism{9, 5, prism_edges, prism_faces};
+constexpr element_shape pyramid{8, 5, pyramid_edges, pyramid_faces};
+} // namespace shape
+
+/// Properties of a gmsh element type.  The vertices are the first nodes of the
+/// element and the edges and faces are numbered by their vertices.
+struct element_traits
+{
+    /// Number of nodes, zero if the element type is not supported
+    int nodes;
+    /// Zero for points, one for lines, two for surfaces and three for volumes
+    int dimension;
+    /// Number of corner nodes
+    int vertices;
+    /// Polynomial order of the interpolation
+    int order;
+    /// Equivalent VTK cell type, zero if VTK has no equivalent.  The node
+    /// ordering of the higher order VTK cells may differ from Gmsh.
+    int vtk_type;
+    element_shape shape;
+};
+
+/// Traits of each gmsh element type indexed by ELEMENT_TYPE_ID
+struct element_traits_table
+{
+    element_traits entries[HEXAHEDRON125 + 1];
+
+    constexpr element_traits const& operator[](int const element_type_id) const
+    {
+        return entries[element_type_id];
+    }
+};
+
+constexpr element_traits_table make_element_traits_table()
+{
+    element_traits_table table{};
+
+    // clang-format off
+    table.entries[POINT]          = {1,   0, 1, 0, 1,  shape::point};
+    table.entries[LINE2]          = {2,   1, 2, 1, 3,  shape::line};
+    table.entries[LINE3]          = {3,   1, 2, 2, 21, shape::line};
+    table.entries[EDGE4]          = {4,   1, 2, 3, 68, shape::line};
+    table.entries[EDGE5]          = {5,   1, 2, 4, 68, shape::line};
+    table.entries[EDGE6]          = {6,   1, 2, 5, 68, shape::line};
+    table.entries[TRIANGLE3]      = {3,   2, 3, 1, 5,  shape::triangle};
+    table.entries[TRIANGLE6]      = {6,   2, 3, 2, 22, shape::triangle};
+    table.entries[TRIANGLE9]      = {9,   2, 3, 3, 0,  shape::triangle};
+    table.entries[TRIANGLE10]     = {10,  2, 3, 3, 69, shape::triangle};
+    table.entries[TRIANGLE12]     = {12,  2, 3, 4, 0,  shape::triangle};
+    table.entries[TRIANGLE15]     = {15,  2, 3, 4, 69, shape::triangle};
+    table.entries[TRIANGLE15_IC]  = {15,  2, 3, 5, 0,  shape::triangle};
+    table.entries[TRIANGLE21]     = {21,  2, 3, 5, 69, shape::triangle};
+    table.entries[QUADRILATERAL4] = {4,   2, 4, 1, 9,  shape::quadrilateral};
+    table.entries[QUADRILATERAL8] = {8,   2, 4, 2, 23, shape::quadrilateral};
+    table.entries[QUADRILATERAL9] = {9,   2, 4, 2, 28, shape::quadrilateral};
+    table.entries[TETRAHEDRON4]   = {4,   3, 4, 1, 10, shape::tetrahedron};
+    table.entries[TETRAHEDRON10]  = {10,  3, 4, 2, 24, shape::tetrahedron};
+    table.entries[TETRAHEDRON20]  = {20,  3, 4, 3, 71, shape::tetrahedron};
+    table.entries[TETRAHEDRON35]  = {35,  3, 4, 4, 71, shape::tetrahedron};
+    table.entries[TETRAHEDRON56]  = {56,  3, 4, 5, 71, shape::tetrahedron};
+    table.entries[HEXAHEDRON8]    = {8,   3, 8, 1, 12, shape::hexahedron};
+    table.entries[HEXAHEDRON20]   = {20,  3, 8, 2, 25, shape::hexahedron};
+    table.entries[HEXAHEDRON27]   = {27,  3, 8, 2, 29, shape::hexahedron};
+    table.entries[HEXAHEDRON64]   = {64,  3, 8, 3, 72, shape::hexahedron};
+    table.entries[HEXAHEDRON125]  = {125, 3, 8, 4, 72, shape::hexahedron};
+    table.entries[PRISM6]         = {6,   3, 6, 1, 13, shape::prism};
+    table.entries[PRISM15]        = {15,  3, 6, 2, 26, shape::prism};
+    table.entries[PRISM18]        = {18,  3, 6, 2, 32, shape::prism};
+    table.entries[PYRAMID5]       = {5,   3, 5, 1, 14, shape::pyramid};
+    table.entries[PYRAMID13]      = {13,  3, 5, 2, 27, shape::pyramid};
+    table.entries[PYRAMID14]      = {14,  3, 5, 2, 0,  shape::pyramid};
+    // clang-format on
+
+    return table;
+}
+
+constexpr element_traits_table element_traits_of = make_element_traits_table();
+
+/// \return true if the gmsh element type is supported
+constexpr bool is_supported(int const element_type_id) noexcept
+{
+    return element_type_id > 0 && element_type_id <= HEXAHEDRON125 &&
+           element_traits_of[element_type_id].nodes > 0;
+}
+
+/// Compile-time traits of a gmsh element type for kernels specialised on the
+/// element type, e.g. a loop over the nodes of each element with a constant
+/// trip count.  \sa visit_element_type
+template <int ElementTypeId>
+struct element_type
+{
+    static_assert(is_supported(ElementTypeId), "Element type is not supported");
+
+    static constexpr int id = ElementTypeId;
+
+    static constexpr int nodes = element_traits_of[ElementTypeId].nodes;
+
+    static constexpr int dimension = element_traits_of[ElementTypeId].dimension;
+
+    static constexpr int vertices = element_traits_of[ElementTypeId].vertices;
+
+    static constexpr int order = element_traits_of[ElementTypeId].order;
+};
+
+template <int ElementTypeId>
+constexpr int element_type<ElementTypeId>::id;
+template <int ElementTypeId>
+constexpr int element_type<ElementTypeId>::nodes;
+template <int ElementTypeId>
+constexpr int element_type<ElementTypeId>::dimension;
+template <int ElementTypeId>
+constexpr int element_type<ElementTypeId>::vertices;
+template <int ElementTypeId>
+constexpr int element_type<ElementTypeId>::order;
+
+/// Call the function with an element_type<ElementTypeId> object matching the
+/// runtime element type, so the branch on the element type is taken once for
+/// a group of elements rather than once for each element
+/// \return the value returned by the function
+template <typename Function>
+decltype(auto) visit_element_type(int const element_type_id, Function&& function)
+{
+    switch (element_type_id)
+    {
+        case POINT: return function(element_type<POINT>{});
+        case LINE2: return function(element_type<LINE2>{});
+        case LINE3: return function(element_type<LINE3>{});
+        case EDGE4: return function(element_type<EDGE4>{});
+        case EDGE5: return function(element_type<EDGE5>{});
+        case EDGE6: return function(element_type<EDGE6>{});
+        case TRIANGLE3: return function(element_type<TRIANGLE3>{});
+        case TRIANGLE6: return function(element_type<TRIANGLE6>{});
+        case TRIANGLE9: return function(element_type<TRIANGLE9>{});
+        case TRIANGLE10: return function(element_type<TRIANGLE10>{});
+        case TRIANGLE12: return function(element_type<TRIANGLE12>{});
+        case TRIANGLE15: return function(element_type<TRIANGLE15>{});
+        case TRIANGLE15_IC: return function(element_type<TRIANGLE15_IC>{});
+        case TRIANGLE21: return function(element_type<TRIANGLE21>{});
+        case QUADRILATERAL4: return function(element_type<QUADRILATERAL4>{});
+        case QUADRILATERAL8: return function(element_type<QUADRILATERAL8>{});
+        case QUADRILATERAL9: return function(element_type<QUADRILATERAL9>{});
+        case TETRAHEDRON4: return function(element_type<TETRAHEDRON4>{});
+        case TETRAHEDRON10: return function(element_type<TETRAHEDRON10>{});
+        case TETRAHEDRON20: return function(element_type<TETRAHEDRON20>{});
+        case TETRAHEDRON35: return function(element_type<TETRAHEDRON35>{});
+        case TETRAHEDRON56: return function(element_type<TETRAHEDRON56>{});
+        case HEXAHEDRON8: return function(element_type<HEXAHEDRON8>{});
+        case HEXAHEDRON20: return function(element_type<HEXAHEDRON20>{});
+        case HEXAHEDRON27: return function(element_type<HEXAHEDRON27>{});
+        case HEXAHEDRON64: return function(element_type<HEXAHEDRON64>{});
+        case HEXAHEDRON125: return function(element_type<HEXAHEDRON125>{});
+        case PRISM6: return function(element_type<PRISM6>{});
+        case PRISM15: return function(element_type<PRISM15>{});
+        case PRISM18: return function(element_type<PRISM18>{});
+        case PYRAMID5: return function(element_type<PYRAMID5>{});
+        case PYRAMID13: return function(element_type<PYRAMID13>{});
+        case PYRAMID14: return function(element_type<PYRAMID14>{});
+        default:
+            throw std::domain_error("The elementTypeId " + std::to_string(element_type_id) +
+                                    " is not implemented");
+    }
+}
+} // namespace imr
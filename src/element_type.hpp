@@ -0,0 +1,54 @@
+
+#pragma once
+
+namespace imr
+{
+/// Gmsh element numbering scheme
+enum ELEMENT_TYPE_ID {
+    // Standard linear elements
+    LINE2 = 1,
+    TRIANGLE3,
+    QUADRILATERAL4,
+    TETRAHEDRON4,
+    HEXAHEDRON8,
+    PRISM6,
+    PYRAMID5,
+    // Quadratic elements
+    LINE3,
+    TRIANGLE6,
+    QUADRILATERAL9, // 4 vertex, 4 edges and 1 face node
+    TETRAHEDRON10,
+    HEXAHEDRON27,
+    PRISM18,
+    PYRAMID14,
+    POINT = 15,
+    QUADRILATERAL8,
+    HEXAHEDRON20,
+    PRISM15,
+    PYRAMID13,
+    TRIANGLE9 = 20,
+    TRIANGLE10,
+    TRIANGLE12,
+    TRIANGLE15,
+    TRIANGLE15_IC, // Incomplete 15 node triangle
+    TRIANGLE21 = 25,
+    EDGE4,
+    EDGE5,
+    EDGE6,
+    TETRAHEDRON20,
+    TETRAHEDRON35,
+    TETRAHEDRON56,
+    HEXAHEDRON64 = 92,
+    HEXAHEDRON125
+};
+
+/// Return the number of nodes for a gmsh element type
+/// \param elementTypeId gmsh element number
+/// \return number of nodes for the element
+int nodes_per_element(int const elementTypeId);
+
+/// Return the topological dimension of a gmsh element type
+/// \param elementTypeId gmsh element number
+/// \return zero for points, one for lines, two for surfaces and three for volumes
+int element_dimension(int const elementTypeId);
+} // namespace imr
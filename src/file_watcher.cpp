@@ -0,0 +1,116 @@
+
+#include "file_watcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace imr
+{
+namespace
+{
+std::runtime_error system_error(std::string const& message)
+{
+    return std::runtime_error(message + ": " + std::strerror(errno));
+}
+}
+
+file_watcher::file_watcher(std::vector<std::string> const& file_names) : m_file_names(file_names)
+{
+    m_inotify = ::inotify_init1(IN_CLOEXEC);
+
+    if (m_inotify == -1) throw system_error("File changes could not be watched");
+
+    for (std::size_t i = 0; i < file_names.size(); ++i)
+    {
+        auto const separator = file_names[i].find_last_of('/');
+
+        auto const directory = separator == std::string::npos
+                                   ? std::string(".")
+                                   : file_names[i].substr(0, separator + 1);
+
+        auto const watch = ::inotify_add_watch(m_inotify,
+                                               directory.c_str(),
+                                               IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch == -1)
+        {
+            throw system_error("Directory " + directory + " could not be watched");
+        }
+
+        // Adding the same directory again returns the same watch descriptor
+        m_watches[watch].emplace_back(i, file_names[i].substr(separator + 1));
+    }
+}
+
+file_watcher::~file_watcher()
+{
+    if (m_inotify != -1) ::close(m_inotify);
+}
+
+std::vector<std::string> file_watcher::wait(int const settle_milliseconds)
+{
+    std::vector<bool> changed(m_file_names.size(), false);
+
+    // Block until one of the files changes
+    while (std::find(begin(changed), end(changed), true) == end(changed))
+    {
+        if (poll(-1)) read_events(changed);
+    }
+
+    // Collect the changes following it until the writes have settled
+    while (poll(settle_milliseconds)) read_events(changed);
+
+    std::vector<std::string> changed_files;
+    for (std::size_t i = 0; i < changed.size(); ++i)
+    {
+        if (changed[i]) changed_files.push_back(m_file_names[i]);
+    }
+    return changed_files;
+}
+
+bool file_watcher::poll(int const timeout_milliseconds) const
+{
+    pollfd descriptor{m_inotify, POLLIN, 0};
+
+    auto const ready = ::poll(&descriptor, 1, timeout_milliseconds);
+
+    if (ready == -1 && errno != EINTR) throw system_error("File changes could not be read");
+
+    return ready > 0;
+}
+
+void file_watcher::read_events(std::vector<bool>& changed)
+{
+    alignas(inotify_event) char buffer[4096];
+
+    auto const length = ::read(m_inotify, buffer, sizeof(buffer));
+
+    if (length == -1)
+    {
+        if (errno == EINTR || errno == EAGAIN) return;
+
+        throw system_error("File changes could not be read");
+    }
+
+    for (auto position = buffer; position < buffer + length;)
+    {
+        auto const event = reinterpret_cast<inotify_event const*>(position);
+
+        auto const watch = m_watches.find(event->wd);
+
+        if (watch != end(m_watches) && event->len > 0)
+        {
+            for (auto const& file : watch->second)
+            {
+                if (file.second == event->name) changed[file.first] = true;
+            }
+        }
+        position += sizeof(inotify_event) + event->len;
+    }
+}
+} // namespace imr
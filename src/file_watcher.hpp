@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace imr
+{
+/// file_watcher waits for a set of files to change on disk using inotify.
+/// The directories of the files are watched rather than the files, since
+/// mesh generators commonly replace a file by writing a new one and moving
+/// it over the original.
+class file_watcher
+{
+public:
+    /// \param file_names Files to watch for changes
+    explicit file_watcher(std::vector<std::string> const& file_names);
+
+    ~file_watcher();
+
+    file_watcher(file_watcher const&) = delete;
+    file_watcher& operator=(file_watcher const&) = delete;
+
+    /// Block until at least one of the files has been written, then wait
+    /// for the writes to settle for the given number of milliseconds
+    /// \return The files which changed, in the order they were given
+    std::vector<std::string> wait(int const settle_milliseconds = 200);
+
+private:
+    /// Wait for events up to the timeout (-1 to wait indefinitely)
+    /// \return true if there are events to read
+    bool poll(int const timeout_milliseconds) const;
+
+    /// Read the pending events and mark the files which changed
+    void read_events(std::vector<bool>& changed);
+
+private:
+    int m_inotify = -1;
+
+    std::vector<std::string> m_file_names;
+
+    /// Watch descriptor of each directory and the files watched in it, given
+    /// by their index and the name relative to the directory
+    std::map<int, std::vector<std::pair<std::size_t, std::string>>> m_watches;
+};
+} // namespace imr
@@ -0,0 +1,359 @@
+
+#include "gmsh_parser.hpp"
+
+#include "element_type.hpp"
+#include "phase_timer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace imr
+{
+gmsh_parser::gmsh_parser(std::size_t const batch_size)
+    : m_batch_size(std::max<std::size_t>(batch_size, 1))
+{
+}
+
+void gmsh_parser::parse(std::string const& file_name, gmsh_visitor& visitor)
+{
+    std::fstream gmsh_file(file_name);
+
+    if (!gmsh_file.is_open())
+    {
+        throw std::domain_error("Input file " + file_name + " was not able to be opened");
+    }
+    parse(gmsh_file, visitor);
+}
+
+void gmsh_parser::parse(std::istream& gmsh_file, gmsh_visitor& visitor)
+{
+    // Loop around file and read in keyword tokens
+    while (parse_section(gmsh_file, visitor))
+    {
+    }
+}
+
+bool gmsh_parser::parse_section(std::istream& gmsh_file, gmsh_visitor& visitor)
+{
+    std::string token, null;
+
+    if (gmsh_file >> token)
+    {
+        if (token == "$MeshFormat")
+        {
+            float gmshVersion;     // File format version
+            std::int32_t fileType; // ASCII or binary
+            std::int32_t dataType; // Precision
+
+            gmsh_file >> gmshVersion >> fileType >> dataType;
+
+            m_binary = fileType == 1;
+
+            if (m_binary)
+            {
+                // The format line is followed by the integer one written in
+                // the byte order of the machine that wrote the file
+                gmsh_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+                std::int32_t one = 0;
+                gmsh_file.read(reinterpret_cast<char*>(&one), sizeof(one));
+
+                if (one != 1 || dataType != sizeof(double))
+                {
+                    throw std::domain_error("Binary gmsh files are only supported with the byte "
+                                            "order and the double precision of this machine");
+                }
+            }
+            visitor.format(gmshVersion, fileType, dataType);
+        }
+        else if (token == "$PhysicalNames")
+        {
+            std::string physical_name;
+
+            std::int32_t physicalIds;
+            gmsh_file >> physicalIds;
+
+            for (auto i = 0; i < physicalIds; ++i)
+            {
+                std::int32_t dimension, physicalId;
+                gmsh_file >> dimension >> physicalId >> physical_name;
+
+                // Extract the name from the quotes
+                physical_name.erase(std::remove(physical_name.begin(), physical_name.end(), '\"'),
+                                    physical_name.end());
+
+                visitor.physical_name(dimension, physicalId, physical_name);
+            }
+            gmsh_file >> null;
+        }
+        else if (token == "$Nodes")
+        {
+            parse_nodes(gmsh_file, visitor);
+        }
+        else if (token == "$Elements")
+        {
+            parse_elements(gmsh_file, visitor);
+        }
+        return true;
+    }
+    return false;
+}
+
+void gmsh_parser::parse_nodes(std::istream& gmsh_file, gmsh_visitor& visitor)
+{
+    scoped_timer const timer("parse nodes");
+
+    std::int64_t number_of_nodes;
+    gmsh_file >> number_of_nodes;
+
+    visitor.begin_nodes(number_of_nodes);
+
+    // The binary records start on the line after the number of nodes
+    if (m_binary) gmsh_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    for (std::int64_t first = 0; first < number_of_nodes; first += m_batch_size)
+    {
+        m_nodes.resize(std::min<std::int64_t>(m_batch_size, number_of_nodes - first));
+
+        for (auto& node : m_nodes)
+        {
+            if (m_binary)
+            {
+                std::int32_t id;
+                gmsh_file.read(reinterpret_cast<char*>(&id), sizeof(id));
+                gmsh_file.read(reinterpret_cast<char*>(node.coordinates.data()),
+                               sizeof(node.coordinates));
+                node.id = id;
+            }
+            else
+            {
+                gmsh_file >> node.id >> node.coordinates[0] >> node.coordinates[1] >>
+                    node.coordinates[2];
+            }
+        }
+        visitor.nodes({m_nodes.data(), m_nodes.size()});
+    }
+}
+
+void gmsh_parser::parse_elements(std::istream& gmsh_file, gmsh_visitor& visitor)
+{
+    scoped_timer const timer("parse elements");
+
+    std::int64_t number_of_elements;
+    gmsh_file >> number_of_elements;
+
+    visitor.begin_elements(number_of_elements);
+
+    if (m_binary)
+    {
+        parse_binary_elements(gmsh_file, visitor, number_of_elements);
+        return;
+    }
+
+    for (std::int64_t elementId = 0; elementId < number_of_elements; elementId++)
+    {
+        std::int32_t id = 0, numberOfTags = 0, elementTypeId = 0;
+
+        gmsh_file >> id >> elementTypeId >> numberOfTags;
+
+        auto const numberOfNodes = nodes_per_element(elementTypeId);
+
+        // The visitor selects the elements by their physical id (first tag)
+        if (numberOfTags <= 0) throw std::domain_error("Element tags vector not filled\n");
+
+        auto const tags_begin = m_tags.size();
+
+        for (auto i = 0; i < numberOfTags; ++i)
+        {
+            std::int32_t tag;
+            gmsh_file >> tag;
+            m_tags.push_back(tag);
+        }
+
+        span<std::int32_t const> const tags(m_tags.data() + tags_begin, numberOfTags);
+
+        if (!visitor.accept(elementTypeId, tags))
+        {
+            m_tags.resize(tags_begin);
+            gmsh_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            continue;
+        }
+
+        m_offsets.emplace_back(tags_begin, m_node_indices.size());
+
+        for (auto i = 0; i < numberOfNodes; ++i)
+        {
+            std::int64_t node_index;
+            gmsh_file >> node_index;
+            m_node_indices.push_back(node_index);
+        }
+
+        m_elements.push_back({id, elementTypeId, {}, {}});
+
+        if (m_elements.size() == m_batch_size) flush_elements(visitor);
+    }
+    flush_elements(visitor);
+}
+
+void gmsh_parser::parse_binary_elements(std::istream& gmsh_file,
+                                        gmsh_visitor& visitor,
+                                        std::int64_t const number_of_elements)
+{
+    gmsh_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    // The elements are given in blocks of the same type and number of tags
+    for (std::int64_t elementId = 0; elementId < number_of_elements;)
+    {
+        std::int32_t header[3]; // Element type, number of elements and tags
+        gmsh_file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+        if (!gmsh_file || header[1] <= 0)
+        {
+            throw std::domain_error("The binary elements section is incomplete");
+        }
+
+        auto const elementTypeId = header[0];
+        auto const numberOfTags  = header[2];
+        auto const numberOfNodes = nodes_per_element(elementTypeId);
+
+        if (numberOfTags <= 0) throw std::domain_error("Element tags vector not filled\n");
+
+        // Element id, tags and nodes of each element
+        m_record.resize(1 + numberOfTags + numberOfNodes);
+
+        for (auto i = 0; i < header[1]; ++i, ++elementId)
+        {
+            gmsh_file.read(reinterpret_cast<char*>(m_record.data()),
+                           m_record.size() * sizeof(std::int32_t));
+
+            auto const tags_begin = m_tags.size();
+
+            m_tags.insert(end(m_tags),
+                          begin(m_record) + 1,
+                          begin(m_record) + 1 + numberOfTags);
+
+            span<std::int32_t const> const tags(m_tags.data() + tags_begin, numberOfTags);
+
+            if (!visitor.accept(elementTypeId, tags))
+            {
+                m_tags.resize(tags_begin);
+                continue;
+            }
+
+            m_offsets.emplace_back(tags_begin, m_node_indices.size());
+
+            m_node_indices.insert(end(m_node_indices),
+                                  begin(m_record) + 1 + numberOfTags,
+                                  end(m_record));
+
+            m_elements.push_back({m_record[0], elementTypeId, {}, {}});
+
+            if (m_elements.size() == m_batch_size) flush_elements(visitor);
+        }
+    }
+    flush_elements(visitor);
+}
+
+void gmsh_parser::flush_elements(gmsh_visitor& visitor)
+{
+    if (m_elements.empty()) return;
+
+    // The buffers may have been reallocated while the batch was read, so the
+    // views into the buffers are only formed once the batch is complete
+    for (std::size_t i = 0; i < m_elements.size(); ++i)
+    {
+        auto const tags_end    = i + 1 < m_offsets.size() ? m_offsets[i + 1].first : m_tags.size();
+        auto const indices_end = i + 1 < m_offsets.size() ? m_offsets[i + 1].second
+                                                          : m_node_indices.size();
+
+        m_elements[i].tags = {m_tags.data() + m_offsets[i].first, tags_end - m_offsets[i].first};
+
+        m_elements[i].node_indices = {m_node_indices.data() + m_offsets[i].second,
+                                      indices_end - m_offsets[i].second};
+    }
+
+    {
+        scoped_timer const timer("bucket elements");
+        visitor.elements({m_elements.data(), m_elements.size()});
+    }
+
+    m_elements.clear();
+    m_offsets.clear();
+    m_tags.clear();
+    m_node_indices.clear();
+}
+
+gmsh_index::gmsh_index(std::string const& file_name)
+{
+    scoped_timer const timer("tokenise");
+
+    std::ifstream gmsh_file(file_name, std::ios::binary);
+
+    if (!gmsh_file.is_open())
+    {
+        throw std::domain_error("Input file " + file_name + " was not able to be opened");
+    }
+
+    std::vector<char> block(1 << 20);
+
+    // Offset of the start of the block and of the section being named
+    std::int64_t block_offset = 0, section_offset = 0;
+
+    bool at_line_start = true, in_section_name = false;
+
+    std::string section;
+
+    while (gmsh_file.read(block.data(), block.size()) || gmsh_file.gcount() > 0)
+    {
+        auto const first = block.data();
+        auto const last  = first + gmsh_file.gcount();
+
+        for (auto position = first; position < last;)
+        {
+            if (in_section_name)
+            {
+                auto const name_end = std::find_if(position, last, [](char const c) {
+                    return std::isspace(static_cast<unsigned char>(c));
+                });
+
+                section.append(position, name_end);
+
+                if (name_end == last) break;
+
+                m_offsets.emplace(section, section_offset);
+
+                section.clear();
+                in_section_name = false;
+                position        = name_end;
+                at_line_start   = false;
+            }
+            else if (at_line_start && *position == '$')
+            {
+                in_section_name = true;
+                section_offset  = block_offset + (position - first);
+            }
+            else
+            {
+                // Skip to the start of the next line
+                auto const line_end = static_cast<char*>(
+                    std::memchr(position, '\n', last - position));
+
+                if (line_end == nullptr)
+                {
+                    at_line_start = false;
+                    break;
+                }
+                at_line_start = true;
+                position      = line_end + 1;
+            }
+        }
+        block_offset += gmsh_file.gcount();
+    }
+
+    if (in_section_name) m_offsets.emplace(section, section_offset);
+}
+} // namespace imr
@@ -0,0 +1,145 @@
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "node.hpp"
+#include "span.hpp"
+
+namespace imr
+{
+/// View of a single element passed to a gmsh_visitor.  The tags and node
+/// indices refer to the buffers of the parser and are only valid for the
+/// duration of the callback.
+struct element_record
+{
+    std::int32_t id;
+    std::int32_t type_id;
+    /// Physical id, geometric id and the partition tags \sa element
+    span<std::int32_t const> tags;
+    /// Gmsh node ids of the element
+    span<std::int64_t const> node_indices;
+};
+
+/// gmsh_visitor receives the data of a gmsh file as it is parsed, allowing
+/// consumers to stream the mesh into their own data structures without any
+/// intermediate storage.  The nodes and elements are provided in batches in
+/// the order they appear in the file.  The default callbacks ignore the data.
+class gmsh_visitor
+{
+public:
+    virtual ~gmsh_visitor() = default;
+
+    /// Called for the $MeshFormat section
+    virtual void format(float const /*version*/,
+                        std::int32_t const /*file_type*/,
+                        std::int32_t const /*data_size*/)
+    {
+    }
+
+    /// Called for each entry of the $PhysicalNames section
+    virtual void physical_name(std::int32_t const /*dimension*/,
+                               std::int32_t const /*physical_id*/,
+                               std::string const& /*name*/)
+    {
+    }
+
+    /// Called with the total number of nodes before the first node batch
+    virtual void begin_nodes(std::int64_t const /*number_of_nodes*/) {}
+
+    /// Called for each batch of nodes
+    virtual void nodes(span<node const> const /*batch*/) {}
+
+    /// Called with the total number of elements before the first element batch
+    virtual void begin_elements(std::int64_t const /*number_of_elements*/) {}
+
+    /// Called after the tags of each element are read.  If the element is not
+    /// accepted, the node indices of the element are skipped and the element
+    /// is not included in a batch.
+    /// \return true to accept the element
+    virtual bool accept(std::int32_t const /*type_id*/, span<std::int32_t const> const /*tags*/)
+    {
+        return true;
+    }
+
+    /// Called for each batch of elements
+    virtual void elements(span<element_record const> const /*batch*/) {}
+};
+
+/// gmsh_parser reads a gmsh file in the ASCII or the binary MSH 2.2 format and
+/// forwards the sections to a gmsh_visitor.
+/// The parser reuses its batch buffers, so the number of allocations does not
+/// depend on the size of the mesh.
+class gmsh_parser
+{
+public:
+    /// \param batch_size Maximum number of nodes or elements in a batch
+    explicit gmsh_parser(std::size_t const batch_size = 4096);
+
+    /// Parse the gmsh file and forward the data to the visitor
+    void parse(std::string const& file_name, gmsh_visitor& visitor);
+
+    /// Parse a gmsh stream and forward the data to the visitor
+    void parse(std::istream& gmsh_file, gmsh_visitor& visitor);
+
+    /// Parse the section starting at the current position of the stream
+    /// \return false if the end of the stream was reached
+    bool parse_section(std::istream& gmsh_file, gmsh_visitor& visitor);
+
+private:
+    void parse_nodes(std::istream& gmsh_file, gmsh_visitor& visitor);
+
+    void parse_elements(std::istream& gmsh_file, gmsh_visitor& visitor);
+
+    void parse_binary_elements(std::istream& gmsh_file,
+                               gmsh_visitor& visitor,
+                               std::int64_t const number_of_elements);
+
+    void flush_elements(gmsh_visitor& visitor);
+
+private:
+    std::size_t m_batch_size;
+
+    /// Whether the nodes and the elements are stored in binary \sa format
+    bool m_binary = false;
+
+    std::vector<node> m_nodes;
+
+    std::vector<element_record> m_elements;
+    /// Offsets of each element into the tag and node index buffers
+    std::vector<std::pair<std::size_t, std::size_t>> m_offsets;
+    std::vector<std::int32_t> m_tags;
+    std::vector<std::int64_t> m_node_indices;
+    /// Binary record of an element
+    std::vector<std::int32_t> m_record;
+};
+
+/// gmsh_index holds the byte offsets of the sections ($MeshFormat,
+/// $PhysicalNames, $Nodes, $Elements, ...) of a gmsh file.  The file is scanned
+/// in large blocks for lines starting with '$' without parsing the contents
+/// of the sections, allowing each section to be parsed on demand.
+class gmsh_index
+{
+public:
+    gmsh_index() = default;
+
+    /// Scan the file for the section offsets
+    explicit gmsh_index(std::string const& file_name);
+
+    /// \return true if the section (e.g. "$Nodes") is present in the file
+    bool contains(std::string const& section) const { return m_offsets.count(section) > 0; }
+
+    /// \return the offset of the first occurrence of the section
+    std::int64_t offset(std::string const& section) const { return m_offsets.at(section); }
+
+    /// \return the offsets of the sections in the file
+    std::map<std::string, std::int64_t> const& sections() const noexcept { return m_offsets; }
+
+private:
+    std::map<std::string, std::int64_t> m_offsets;
+};
+} // namespace imr
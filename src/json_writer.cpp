@@ -0,0 +1,254 @@
+
+#include "json_writer.hpp"
+
+#include "real_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace imr
+{
+namespace
+{
+/// Maximum length of an array written on a single line
+constexpr unsigned right_margin = 74;
+
+constexpr std::size_t indent_size = 3;
+}
+
+json_writer::json_writer(int const significant_digits,
+                         bool const single_precision,
+                         json_layout const layout)
+    : m_significant_digits(std::min(std::max(significant_digits, 0), 17)),
+      m_single_precision(single_precision),
+      m_layout(layout)
+{
+}
+
+std::string json_writer::write(Json::Value const& root)
+{
+    m_document.clear();
+    m_indent.clear();
+    m_add_child_values = false;
+
+    if (m_layout == json_layout::compact)
+    {
+        write_compact(root);
+    }
+    else
+    {
+        write_value(root);
+    }
+
+    m_document += "\n";
+
+    std::string document;
+    document.swap(m_document);
+    return document;
+}
+
+void json_writer::write_value(Json::Value const& value)
+{
+    switch (value.type())
+    {
+        case Json::nullValue: push_value("null"); break;
+        case Json::intValue: push_value(Json::valueToString(value.asLargestInt())); break;
+        case Json::uintValue: push_value(Json::valueToString(value.asLargestUInt())); break;
+        case Json::realValue: push_value(real_to_string(value.asDouble())); break;
+        case Json::stringValue:
+            push_value(Json::valueToQuotedString(value.asCString()));
+            break;
+        case Json::booleanValue: push_value(value.asBool() ? "true" : "false"); break;
+        case Json::arrayValue: write_array(value); break;
+        case Json::objectValue:
+        {
+            auto const members = value.getMemberNames();
+
+            if (members.empty())
+            {
+                push_value("{}");
+                break;
+            }
+            write_with_indent("{");
+            m_indent.append(indent_size, ' ');
+
+            for (auto member = begin(members); member != end(members); ++member)
+            {
+                if (member != begin(members)) m_document += ',';
+
+                write_with_indent(Json::valueToQuotedString(member->c_str()));
+                m_document += " : ";
+                write_value(value[*member]);
+            }
+            m_indent.resize(m_indent.size() - indent_size);
+            write_with_indent("}");
+        }
+        break;
+    }
+}
+
+void json_writer::write_array(Json::Value const& value)
+{
+    auto const size = value.size();
+
+    if (size == 0)
+    {
+        push_value("[]");
+        return;
+    }
+
+    if (is_multiline_array(value))
+    {
+        write_with_indent("[");
+        m_indent.append(indent_size, ' ');
+
+        auto const has_child_values = !m_child_values.empty();
+
+        for (Json::ArrayIndex index = 0; index < size; ++index)
+        {
+            if (index > 0) m_document += ',';
+
+            if (has_child_values)
+            {
+                write_with_indent(m_child_values[index]);
+            }
+            else
+            {
+                write_indent();
+                write_value(value[index]);
+            }
+        }
+        m_indent.resize(m_indent.size() - indent_size);
+        write_with_indent("]");
+    }
+    else
+    {
+        m_document += "[ ";
+        for (Json::ArrayIndex index = 0; index < size; ++index)
+        {
+            if (index > 0) m_document += ", ";
+            m_document += m_child_values[index];
+        }
+        m_document += " ]";
+    }
+}
+
+void json_writer::write_compact(Json::Value const& value)
+{
+    switch (value.type())
+    {
+        case Json::arrayValue:
+        {
+            m_document += '[';
+
+            for (Json::ArrayIndex index = 0; index < value.size(); ++index)
+            {
+                if (index > 0) m_document += ',';
+                write_compact(value[index]);
+            }
+            m_document += ']';
+        }
+        break;
+        case Json::objectValue:
+        {
+            auto const members = value.getMemberNames();
+
+            m_document += '{';
+
+            for (auto member = begin(members); member != end(members); ++member)
+            {
+                if (member != begin(members)) m_document += ',';
+
+                m_document += Json::valueToQuotedString(member->c_str());
+                m_document += ':';
+                write_compact(value[*member]);
+            }
+            m_document += '}';
+        }
+        break;
+        default: write_value(value); break;
+    }
+}
+
+bool json_writer::is_multiline_array(Json::Value const& value)
+{
+    auto const size = value.size();
+
+    auto is_multiline = size * 3 >= right_margin;
+
+    m_child_values.clear();
+
+    for (Json::ArrayIndex index = 0; index < size && !is_multiline; ++index)
+    {
+        auto const& child = value[index];
+        is_multiline = (child.isArray() || child.isObject()) && child.size() > 0;
+    }
+
+    if (!is_multiline)
+    {
+        m_child_values.reserve(size);
+        m_add_child_values = true;
+
+        // '[ ' + ', ' between each of the values + ' ]'
+        auto line_length = 4 + (size - 1) * 2;
+
+        for (Json::ArrayIndex index = 0; index < size; ++index)
+        {
+            write_value(value[index]);
+            line_length += m_child_values[index].size();
+        }
+        m_add_child_values = false;
+
+        is_multiline = line_length >= right_margin;
+    }
+    return is_multiline;
+}
+
+void json_writer::push_value(std::string const& value)
+{
+    if (m_add_child_values)
+    {
+        m_child_values.push_back(value);
+    }
+    else
+    {
+        m_document += value;
+    }
+}
+
+void json_writer::write_indent()
+{
+    if (!m_document.empty())
+    {
+        // Already indented
+        if (m_document.back() == ' ') return;
+
+        if (m_document.back() != '\n') m_document += '\n';
+    }
+    m_document += m_indent;
+}
+
+void json_writer::write_with_indent(std::string const& value)
+{
+    write_indent();
+    m_document += value;
+}
+
+std::string json_writer::real_to_string(double const value) const
+{
+    // Non-finite values are written as Json::StyledWriter does
+    if (std::isnan(value)) return "null";
+
+    if (std::isinf(value)) return value < 0.0 ? "-1e+9999" : "1e+9999";
+
+    char buffer[real_buffer_size];
+
+    auto const length = m_significant_digits > 0
+                            ? format_significant(value, m_significant_digits, buffer)
+                            : m_single_precision
+                                  ? format_shortest(static_cast<float>(value), buffer)
+                                  : format_shortest(value, buffer);
+
+    return {buffer, static_cast<std::size_t>(length)};
+}
+} // namespace imr
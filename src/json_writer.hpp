@@ -0,0 +1,72 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+namespace imr
+{
+/// Layout of a written JSON document
+enum class json_layout
+{
+    /// Indented as Json::StyledWriter
+    styled,
+    /// Without any whitespace
+    compact
+};
+
+/// json_writer writes a JSON document in the layout of Json::StyledWriter
+/// (three space indentation with the short arrays on a single line).  The
+/// real numbers are written with digits which read back exactly (shortest in
+/// almost all cases \sa format_shortest) or with a fixed number of
+/// significant digits.  The compact layout drops
+/// the whitespace altogether.
+class json_writer
+{
+public:
+    /// \param significant_digits Significant digits of the real numbers, or
+    ///        zero for digits which read back exactly
+    /// \param single_precision Write digits which read back as the same
+    ///        float rather than the same double
+    /// \param layout Indented or compact document
+    explicit json_writer(int const significant_digits = 0,
+                         bool const single_precision = false,
+                         json_layout const layout    = json_layout::styled);
+
+    /// \return the document followed by a new line
+    std::string write(Json::Value const& root);
+
+private:
+    void write_value(Json::Value const& value);
+
+    void write_array(Json::Value const& value);
+
+    /// Write the arrays and the objects without whitespace
+    void write_compact(Json::Value const& value);
+
+    /// \return true if the array does not fit on a single line, otherwise the
+    /// members of the array are formatted into the child values
+    bool is_multiline_array(Json::Value const& value);
+
+    void push_value(std::string const& value);
+
+    void write_indent();
+
+    void write_with_indent(std::string const& value);
+
+    std::string real_to_string(double const value) const;
+
+private:
+    int m_significant_digits;
+    bool m_single_precision;
+    json_layout m_layout;
+
+    std::string m_document;
+    std::string m_indent;
+
+    std::vector<std::string> m_child_values;
+    bool m_add_child_values = false;
+};
+} // namespace imr
@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include <iostream>
+
+namespace imr
+{
+namespace detail
+{
+inline std::ostream*& log_target() noexcept
+{
+    thread_local std::ostream* target = &std::cout;
+    return target;
+}
+}
+
+/// Return the stream the progress of a conversion on the calling thread is
+/// written to, which is std::cout unless redirected by a scoped_log
+inline std::ostream& log_stream() noexcept { return *detail::log_target(); }
+
+/// scoped_log redirects the progress messages of the calling thread into a
+/// stream until it is destroyed, allowing concurrent conversions to keep the
+/// messages of each file together
+class scoped_log
+{
+public:
+    explicit scoped_log(std::ostream& stream) : m_previous(detail::log_target())
+    {
+        detail::log_target() = &stream;
+    }
+
+    ~scoped_log() { detail::log_target() = m_previous; }
+
+    scoped_log(scoped_log const&) = delete;
+    scoped_log& operator=(scoped_log const&) = delete;
+
+private:
+    std::ostream* m_previous;
+};
+} // namespace imr
@@ -1,8 +1,74 @@
 
+#include "batch_scheduler.hpp"
+#include "block_compressor.hpp"
+#include "conversion_cache.hpp"
+#include "file_watcher.hpp"
+#include "log.hpp"
 #include "mesh_reader.hpp"
+#include "parallel_for.hpp"
+#include "partition_metrics.hpp"
+#include "phase_timer.hpp"
 
 #include <boost/program_options.hpp>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+/// Split a comma separated list of command line values
+std::vector<std::string> split(std::string const& values)
+{
+    std::vector<std::string> tokens;
+
+    std::istringstream stream(values);
+    for (std::string token; std::getline(stream, token, ',');)
+    {
+        if (!token.empty()) tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/// \return the zero based partition of a --partition-range bound
+std::int32_t partition_bound(std::string const& bound)
+{
+    if (bound.empty() || bound.size() > 9 ||
+        !std::all_of(begin(bound), end(bound), [](char const c) { return std::isdigit(c); }))
+    {
+        throw std::runtime_error("--partition-range must be given as a:b with 0 <= a <= b, or "
+                                 "as a single partition a\n");
+    }
+    return std::stoi(bound);
+}
+
+/// Describe the options which change the contents of the output files
+std::string conversion_options(boost::program_options::variables_map const& vm)
+{
+    std::ostringstream options;
+
+    for (auto const flag :
+         {"zero-based", "local-ordering", "with-indices", "interprocess-format", "compact"})
+    {
+        options << flag << "=" << vm.count(flag) << ";";
+    }
+    for (auto const value : {"only-physical", "only-dimension", "partition-range"})
+    {
+        options << value << "=" << (vm.count(value) ? vm[value].as<std::string>() : "") << ";";
+    }
+    if (vm.count("merge-tolerance"))
+    {
+        options << "merge-tolerance=" << vm["merge-tolerance"].as<double>() << ";";
+    }
+    options << "coords=" << vm["coords"].as<std::string>() << ";";
+    options << "significant-digits="
+            << (vm.count("significant-digits") ? vm["significant-digits"].as<int>() : 0) << ";";
+    options << "compress=" << vm["compress"].as<std::string>() << ";";
+    return options.str();
+}
+}
 
 int main(int argc, char* argv[])
 {
@@ -34,6 +100,101 @@ int main(int argc, char* argv[])
                               "Write out shared process interfaces (only for decomposed meshes).  "
                               "Default feti-format");
 
+        visible.add_options()("split-files",
+                              "Assemble a single mesh from the input files written by Gmsh "
+                              "for each partition (name_1.msh, name_2.msh, ...)");
+
+        visible.add_options()("only-physical",
+                              po::value<std::string>(),
+                              "Only keep the elements of the comma separated physical groups, "
+                              "e.g. domain,left_boundary");
+
+        visible.add_options()("only-dimension",
+                              po::value<std::string>(),
+                              "Only keep the elements of the comma separated dimensions, e.g. 3 "
+                              "for volume elements");
+
+        visible.add_options()("partition-range",
+                              po::value<std::string>(),
+                              "Only write out the zero based partitions a to b (inclusive) given "
+                              "as a:b, or a single partition a");
+
+        visible.add_options()("merge-tolerance",
+                              po::value<double>(),
+                              "Merge the nodes closer than the given distance and remap the "
+                              "element connectivities onto the remaining nodes");
+
+        visible.add_options()("index-width",
+                              po::value<int>(),
+                              "Hold the node indices of each partition in 32 or 64 bit integers "
+                              "while writing.  Default: 32 bits whenever the node ids fit");
+
+        visible.add_options()("coords",
+                              po::value<std::string>()->default_value("double"),
+                              "Precision of the written coordinates, float or double");
+
+        visible.add_options()("significant-digits",
+                              po::value<int>(),
+                              "Write the coordinates with 1 to 17 significant digits.  Default: "
+                              "digits which read back as the same number");
+
+        visible.add_options()("compact",
+                              "Write the JSON files without whitespace and write the coordinates "
+                              "and the nodal connectivities as flat arrays with a Stride member");
+
+        visible.add_options()("compress",
+                              po::value<std::string>()->default_value("none"),
+                              "Compress the written files with gzip (.gz suffix) in blocks "
+                              "compressed concurrently, or none");
+
+        visible.add_options()("out-of-core",
+                              "Spill the nodes and the elements of each partition to temporary "
+                              "files and process one partition at a time");
+
+        visible.add_options()("memory-budget",
+                              po::value<std::size_t>()->default_value(1024),
+                              "Memory budget in MiB shared by the input files converted "
+                              "concurrently and for the out-of-core mode");
+
+        visible.add_options()("threads",
+                              po::value<unsigned>()->default_value(hardware_threads()),
+                              "Number of threads shared by the input files converted "
+                              "concurrently");
+
+        visible.add_options()("cache",
+                              "Record the hash of the input file and the options in a "
+                              "\"filename.manifest.json\" manifest, skip the conversion when "
+                              "the manifest matches and only rewrite the changed outputs");
+
+        visible.add_options()("watch",
+                              "Keep running and convert the input files again whenever they "
+                              "change on disk");
+
+        visible.add_options()("timings",
+                              "Print the time spent in each phase of the conversion");
+
+        visible.add_options()("timings-report",
+                              po::value<std::string>(),
+                              "Write the time spent in each phase for each partition and thread "
+                              "to a JSON report");
+
+        visible.add_options()("memory",
+                              "Print the memory held by the data structures of each file and the "
+                              "peak resident memory of each phase of the conversion");
+
+        visible.add_options()("trace",
+                              po::value<std::string>(),
+                              "Write a timeline of the phases on each thread in the Chrome trace "
+                              "event format, e.g. --trace trace.json");
+
+        visible.add_options()("metrics",
+                              "Print the load balance and communication volume of each "
+                              "partition");
+
+        visible.add_options()("metrics-report",
+                              "Write the partition metrics to a machine readable "
+                              "\"filename.metrics.json\" report");
+
         po::options_description hidden("Hidden options");
 
         hidden.add_options()("input-file", po::value<std::vector<std::string>>(), "input file");
@@ -80,16 +241,272 @@ int main(int argc, char* argv[])
                                                    ? distributed::interprocess
                                                    : distributed::feti;
 
+        element_filter filter;
+
+        if (vm.count("only-physical"))
+        {
+            for (auto const& name : split(vm["only-physical"].as<std::string>()))
+            {
+                filter.physical_names.insert(name);
+            }
+        }
+
+        if (vm.count("only-dimension"))
+        {
+            for (auto const& dimension : split(vm["only-dimension"].as<std::string>()))
+            {
+                if (dimension.size() != 1 || dimension[0] < '0' || dimension[0] > '3')
+                {
+                    throw std::runtime_error("--only-dimension must be a comma separated list "
+                                             "of the dimensions 0 to 3\n");
+                }
+                filter.dimensions.insert(std::stoi(dimension));
+            }
+        }
+
+        if (vm.count("partition-range"))
+        {
+            auto const range     = vm["partition-range"].as<std::string>();
+            auto const separator = range.find(':');
+
+            filter.first_partition = partition_bound(range.substr(0, separator));
+            filter.last_partition  = separator == std::string::npos
+                                        ? filter.first_partition
+                                        : partition_bound(range.substr(separator + 1));
+
+            if (filter.first_partition > filter.last_partition)
+            {
+                throw std::runtime_error("--partition-range a:b must satisfy a <= b\n");
+            }
+        }
+
+        output_format format;
+
+        if (vm.count("index-width")) format.index_width = vm["index-width"].as<int>();
+
+        auto const& coords = vm["coords"].as<std::string>();
+
+        if (coords != "float" && coords != "double")
+        {
+            throw std::runtime_error("--coords must be float or double\n");
+        }
+        format.single_precision = coords == "float";
+        format.compact          = vm.count("compact") > 0;
+
+        auto const& compress = vm["compress"].as<std::string>();
+
+        if (compress != "none" && compress != "gzip")
+        {
+            throw std::runtime_error("--compress must be gzip or none\n");
+        }
+        format.compress = compress == "gzip" ? compression::gzip : compression::none;
+
+        if (!compression_available(format.compress))
+        {
+            throw std::runtime_error("gzip compression requires imr to be built with zlib\n");
+        }
+
+        if (vm.count("significant-digits"))
+        {
+            format.significant_digits = vm["significant-digits"].as<int>();
+
+            if (format.significant_digits < 1 || format.significant_digits > 17)
+            {
+                throw std::runtime_error("--significant-digits must be between 1 and 17\n");
+            }
+        }
+
         std::cout << "\nPerforming mesh conversion with "
                   << (indexing == IndexingBase::Zero ? "zero" : "one")
                   << " based indexing for node indices\n\n";
 
         if (vm.count("input-file"))
         {
+            auto const options = conversion_options(vm);
+
+            // Return the cache for the input file, or nullptr when disabled
+            auto const open_cache = [&](std::string const& input) {
+                return vm.count("cache") ? std::make_unique<conversion_cache>(input, options)
+                                         : std::unique_ptr<conversion_cache>();
+            };
+
+            auto const convert = [&](mesh_reader& reader, conversion_cache* cache = nullptr) {
+                if (vm.count("merge-tolerance"))
+                {
+                    reader.merge_coincident_nodes(vm["merge-tolerance"].as<double>());
+                }
+                reader.set_output_format(format);
+                reader.write(vm.count("with-indices") > 0, cache);
+
+                if (vm.count("memory")) reader.memory().print(log_stream());
+
+                if (cache) cache->save();
+
+                if (vm.count("metrics") || vm.count("metrics-report"))
+                {
+                    partition_metrics const metrics(reader);
+
+                    if (vm.count("metrics")) metrics.print(log_stream());
+
+                    if (vm.count("metrics-report"))
+                    {
+                        auto const& name = reader.file_name();
+                        metrics.write(name.substr(0, name.find_last_of('.')) + ".metrics.json");
+                    }
+                }
+            };
+
+            // A file given more than once is converted once, since concurrent
+            // conversions of the same file would write the same outputs
+            std::vector<std::string> input_files;
             for (auto const& input : vm["input-file"].as<std::vector<std::string>>())
             {
-                mesh_reader reader(input, ordering, indexing, distributed_option);
-                reader.write(vm.count("with-indices") > 0);
+                if (std::find(begin(input_files), end(input_files), input) == end(input_files))
+                {
+                    input_files.push_back(input);
+                }
+            }
+
+            auto const memory_budget = vm["memory-budget"].as<std::size_t>() << 20;
+
+            if (vm.count("watch") && (vm.count("split-files") || vm.count("out-of-core")))
+            {
+                throw std::runtime_error("--watch is not supported with --split-files or "
+                                         "--out-of-core\n");
+            }
+
+            enable_timers(vm.count("timings") || vm.count("timings-report") || vm.count("trace") ||
+                          vm.count("memory"));
+            enable_tracing(vm.count("trace") > 0);
+            enable_memory_accounting(vm.count("memory") > 0);
+
+            auto const report_timings = [&]() {
+                if (vm.count("timings") || vm.count("memory")) print_timings(std::cout);
+
+                if (vm.count("timings-report"))
+                {
+                    write_timings(vm["timings-report"].as<std::string>());
+                }
+                if (vm.count("trace")) write_trace(vm["trace"].as<std::string>());
+            };
+
+            if (vm.count("split-files"))
+            {
+                mesh_reader reader(input_files, ordering, indexing, distributed_option, filter);
+                convert(reader);
+                report_timings();
+            }
+            else if (vm.count("out-of-core"))
+            {
+                if (vm.count("merge-tolerance"))
+                {
+                    throw std::runtime_error("--merge-tolerance is not supported with "
+                                             "--out-of-core\n");
+                }
+                if (vm.count("metrics") || vm.count("metrics-report"))
+                {
+                    throw std::runtime_error("--metrics and --metrics-report are not supported "
+                                             "with --out-of-core\n");
+                }
+
+                batch_scheduler scheduler(memory_budget, vm["threads"].as<unsigned>());
+
+                // Each file spills to disk beyond the memory reserved for it
+                scheduler.run(input_files,
+                              [&](std::string const& input, std::size_t const memory) {
+                                  scoped_timer const timer("convert file");
+
+                                  log_stream() << "Converting " << input << "\n";
+
+                                  auto const cache = open_cache(input);
+
+                                  if (cache && cache->up_to_date())
+                                  {
+                                      log_stream() << "  Outputs are up to date\n";
+                                      return;
+                                  }
+
+                                  mesh_reader reader(input,
+                                                     ordering,
+                                                     indexing,
+                                                     distributed_option,
+                                                     memory,
+                                                     filter);
+                                  convert(reader, cache.get());
+                              },
+                              std::cout);
+                report_timings();
+            }
+            else
+            {
+                batch_scheduler scheduler(memory_budget, vm["threads"].as<unsigned>());
+
+                auto const watch = vm.count("watch") > 0;
+
+                // The readers are kept in memory between the conversions when
+                // watching the input files, so a reload reuses their memory
+                std::map<std::string, std::unique_ptr<mesh_reader>> readers;
+                for (auto const& input : input_files) readers[input];
+
+                auto const convert_file = [&](std::string const& input, std::size_t) {
+                    scoped_timer const timer("convert file");
+
+                    log_stream() << "Converting " << input << "\n";
+
+                    auto const cache = open_cache(input);
+
+                    if (cache && cache->up_to_date())
+                    {
+                        log_stream() << "  Outputs are up to date\n";
+                        return;
+                    }
+
+                    auto& reader = readers.at(input);
+
+                    if (reader)
+                    {
+                        reader->reload();
+                    }
+                    else
+                    {
+                        reader = std::make_unique<mesh_reader>(input,
+                                                               ordering,
+                                                               indexing,
+                                                               distributed_option,
+                                                               filter);
+                    }
+                    convert(*reader, cache.get());
+
+                    if (!watch) reader.reset();
+                };
+
+                if (!watch)
+                {
+                    scheduler.run(input_files, convert_file, std::cout);
+                    report_timings();
+                    return 0;
+                }
+
+                // Watch before the first conversion so no change is missed
+                file_watcher watcher(input_files);
+
+                for (auto changed = input_files;; changed = watcher.wait())
+                {
+                    // A failed conversion (e.g. a partially written file) is
+                    // retried on the next change
+                    try
+                    {
+                        scheduler.run(changed, convert_file, std::cout);
+                    }
+                    catch (std::exception& error)
+                    {
+                        std::cerr << "Conversion failed: " << error.what() << std::endl;
+                    }
+                    report_timings();
+                    reset_timers();
+
+                    std::cout << "\nWatching the input files for changes" << std::endl;
+                }
             }
         }
         else
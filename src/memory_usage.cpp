@@ -0,0 +1,69 @@
+
+#include "memory_usage.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <string>
+
+namespace imr
+{
+namespace detail
+{
+std::atomic<bool> memory_accounting_enabled{false};
+}
+
+void enable_memory_accounting(bool const enable) noexcept
+{
+    detail::memory_accounting_enabled.store(enable, std::memory_order_relaxed);
+}
+
+resident_memory read_resident_memory()
+{
+    resident_memory memory;
+
+    std::ifstream status("/proc/self/status");
+
+    // The sizes are given in kB, e.g. "VmRSS:     1234 kB"
+    for (std::string field; status >> field;)
+    {
+        if (field == "VmRSS:")
+        {
+            status >> memory.current;
+            memory.current *= 1024;
+        }
+        else if (field == "VmHWM:")
+        {
+            status >> memory.peak;
+            memory.peak *= 1024;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return memory;
+}
+
+void memory_usage::print(std::ostream& out) const
+{
+    auto const mebibytes = [](std::size_t const bytes) { return bytes / 1048576.0; };
+
+    out << std::fixed << std::setprecision(3);
+
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Data structure" << std::right
+        << std::setw(14) << "MiB"
+        << "\n";
+
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Nodes" << std::right
+        << std::setw(14) << mebibytes(nodes) << "\n";
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Elements" << std::right
+        << std::setw(14) << mebibytes(elements) << "\n";
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Interfaces" << std::right
+        << std::setw(14) << mebibytes(interfaces) << "\n";
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Largest partition elements"
+        << std::right << std::setw(14) << mebibytes(partition_elements) << "\n";
+    out << std::string(2, ' ') << std::left << std::setw(30) << "Largest JSON document"
+        << std::right << std::setw(14) << mebibytes(json_document) << "\n";
+
+    out << std::defaultfloat;
+}
+} // namespace imr
@@ -0,0 +1,58 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace imr
+{
+/// Bytes held by the data structures of a conversion, including the
+/// capacity reserved by the containers and an estimate of the overhead of
+/// the nodes of the associative containers
+struct memory_usage
+{
+    /// Nodal coordinates (nodal_data)
+    std::size_t nodes = 0;
+    /// Element groups (meshes)
+    std::size_t elements = 0;
+    /// Interface nodes of each pair of partitions (interfaceElementMap)
+    std::size_t interfaces = 0;
+    /// Largest copy of the elements of a partition (process_mesh) while writing
+    std::size_t partition_elements = 0;
+    /// Largest JSON document of a partition while writing
+    std::size_t json_document = 0;
+
+    /// Print the bytes held by each of the data structures
+    void print(std::ostream& out) const;
+};
+
+/// Resident set size of the process in bytes
+struct resident_memory
+{
+    std::int64_t current = 0;
+    /// High water mark of the resident set size
+    std::int64_t peak = 0;
+};
+
+/// Return the resident set size of the process from /proc/self/status, or
+/// zeros if it is not available
+resident_memory read_resident_memory();
+
+namespace detail
+{
+extern std::atomic<bool> memory_accounting_enabled;
+}
+
+/// Return true if the memory use of the conversion phases is recorded
+inline bool memory_accounting_enabled() noexcept
+{
+    return detail::memory_accounting_enabled.load(std::memory_order_relaxed);
+}
+
+/// Enable or disable recording the peak resident set size of each timed phase
+/// \sa scoped_timer and the bytes of the partition copies and JSON documents
+/// while writing \sa mesh_reader::memory
+void enable_memory_accounting(bool const enable = true) noexcept;
+} // namespace imr
@@ -1,11 +1,21 @@
 
 #include "mesh_reader.hpp"
 
+#include "block_compressor.hpp"
+#include "element_traits.hpp"
+#include "json_writer.hpp"
+#include "log.hpp"
+#include "node_merger.hpp"
+#include "parallel_for.hpp"
+#include "phase_timer.hpp"
+
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <numeric>
 
 #include <json/json.h>
@@ -15,176 +25,568 @@ namespace imr
 mesh_reader::mesh_reader(std::string const& input_file_name,
                          NodalOrdering const ordering,
                          IndexingBase const base,
-                         distributed const distributed_option)
+                         distributed const distributed_option,
+                         element_filter const& filter)
+    : input_file_name(input_file_name),
+      useZeroBasedIndexing(base == IndexingBase::Zero),
+      useLocalNodalConnectivity(ordering == NodalOrdering::Local),
+      is_feti_format(distributed_option == distributed::feti),
+      m_filter(filter),
+      m_index(input_file_name)
+{
+    for (auto const& section : m_index.sections())
+    {
+        m_unparsed.insert(section.first);
+    }
+    load("$MeshFormat");
+}
+
+mesh_reader::mesh_reader(std::string const& input_file_name,
+                         NodalOrdering const ordering,
+                         IndexingBase const base,
+                         distributed const distributed_option,
+                         std::size_t const memory_budget,
+                         element_filter const& filter)
     : input_file_name(input_file_name),
       useZeroBasedIndexing(base == IndexingBase::Zero),
       useLocalNodalConnectivity(ordering == NodalOrdering::Local),
-      is_feti_format(distributed_option == distributed::feti)
+      is_feti_format(distributed_option == distributed::feti),
+      m_filter(filter),
+      m_storage(std::make_shared<out_of_core_storage>(
+          input_file_name.substr(0, input_file_name.find_last_of('.')), memory_budget))
 {
     fillMesh();
+
+    m_storage->finalise();
+}
+
+namespace
+{
+/// Estimated overhead of a node of a std::map or std::set
+constexpr std::size_t tree_node_bytes = 32;
+
+std::size_t element_bytes(std::vector<element> const& elements)
+{
+    auto bytes = elements.capacity() * sizeof(element);
+
+    // The elements allocated from an arena are accounted with the arena
+    for (auto const& element_data : elements)
+    {
+        if (element_data.node_indices().get_allocator().arena() != nullptr) continue;
+
+        bytes += element_data.partitionTags().capacity() * sizeof(std::int32_t) +
+                 element_data.node_indices().capacity() * sizeof(std::int64_t);
+    }
+    return bytes;
+}
+
+std::size_t mesh_bytes(mesh_reader::Mesh const& mesh)
+{
+    std::size_t bytes = 0;
+
+    for (auto const& group : mesh)
+    {
+        bytes += tree_node_bytes + sizeof(group) + group.first.first.capacity() +
+                 element_bytes(group.second);
+    }
+    return bytes;
+}
+
+template <typename Index>
+std::size_t mesh_bytes(mesh_reader::partition_mesh<Index> const& mesh)
+{
+    std::size_t bytes = 0;
+
+    for (auto const& group : mesh)
+    {
+        bytes += tree_node_bytes + sizeof(group.first) + group.first.first.capacity() +
+                 group.second.memory_bytes();
+    }
+    return bytes;
+}
+
+/// Return the bytes held by a JSON document, where the members of the arrays
+/// and the objects are each held in a node of a map
+std::size_t json_bytes(Json::Value const& value)
+{
+    auto bytes = sizeof(Json::Value);
+
+    if (value.isString())
+    {
+        bytes += value.asString().size() + sizeof(unsigned) + 1;
+    }
+    else if (value.isArray() || value.isObject())
+    {
+        using key_type = Json::Value::ObjectValues::key_type;
+
+        for (auto const& member : value)
+        {
+            bytes += tree_node_bytes + sizeof(key_type) + json_bytes(member);
+        }
+        if (value.isObject())
+        {
+            for (auto const& name : value.getMemberNames()) bytes += name.size() + 1;
+        }
+    }
+    return bytes;
+}
+
+/// Return the name of the monolithic mesh file by removing the partition
+/// suffix from the name of a partition file, e.g. name_1.msh to name.msh
+std::string monolithic_file_name(std::vector<std::string> const& input_file_names)
+{
+    if (input_file_names.empty())
+    {
+        throw std::domain_error("No input files were provided for the partitioned mesh");
+    }
+
+    auto const& file_name = input_file_names.front();
+
+    auto const extension = std::min(file_name.find_last_of('.'), file_name.size());
+    auto const separator = file_name.find_last_of('_', extension);
+
+    if (separator == std::string::npos || separator + 1 == extension ||
+        !std::all_of(begin(file_name) + separator + 1, begin(file_name) + extension, [](auto c) {
+            return std::isdigit(c);
+        }))
+    {
+        return file_name;
+    }
+    return file_name.substr(0, separator) + file_name.substr(extension);
+}
+}
+
+mesh_reader::mesh_reader(std::vector<std::string> const& input_file_names,
+                         NodalOrdering const ordering,
+                         IndexingBase const base,
+                         distributed const distributed_option,
+                         element_filter const& filter)
+    : input_file_name(monolithic_file_name(input_file_names)),
+      useZeroBasedIndexing(base == IndexingBase::Zero),
+      useLocalNodalConnectivity(ordering == NodalOrdering::Local),
+      is_feti_format(distributed_option == distributed::feti),
+      m_filter(filter)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    assemble(input_file_names);
+
+    log_stream() << std::string(2, ' ') << "A total number of " << m_partitions
+                 << " partitions were found in " << input_file_names.size() << " files\n";
+
+    auto const end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    log_stream() << "Mesh data structure filled in " << elapsed_seconds.count() << "s\n";
 }
 
 void mesh_reader::fillMesh()
 {
     auto const start = std::chrono::high_resolution_clock::now();
 
-    std::fstream gmsh_file(input_file_name);
+    parse(input_file_name);
+
+    log_stream() << std::string(2, ' ') << "A total number of " << m_partitions
+                 << " partitions were found\n";
+
+    auto const end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    log_stream() << "Mesh data structure filled in " << elapsed_seconds.count() << "s\n";
+}
+
+/// builder is the gmsh_visitor filling the datastructures of a mesh_reader
+class mesh_reader::builder : public gmsh_visitor
+{
+public:
+    explicit builder(mesh_reader const& reader) : reader(reader) {}
 
-    if (!gmsh_file.is_open())
+    void format(float const version, std::int32_t const, std::int32_t const) override
     {
-        throw std::domain_error("Input file " + input_file_name + " was not able to be opened");
+        reader.checkSupportedGmsh(version);
     }
 
-    std::string token, null;
+    void physical_name(std::int32_t const,
+                       std::int32_t const physical_id,
+                       std::string const& name) override
+    {
+        reader.physicalGroupMap.emplace(physical_id, name);
+    }
 
-    // Loop around file and read in keyword tokens
-    while (!gmsh_file.eof())
+    void begin_nodes(std::int64_t const number_of_nodes) override
     {
-        gmsh_file >> token;
+        if (!reader.m_storage) reader.nodal_data.reserve(number_of_nodes);
 
-        if (token == "$MeshFormat")
-        {
-            float gmshVersion;     // File format version
-            std::int32_t dataType; // Precision
+        reader.m_node_index.reserve(number_of_nodes);
+    }
 
-            gmsh_file >> gmshVersion >> dataType >> null;
-            checkSupportedGmsh(gmshVersion);
+    void nodes(span<node const> const batch) override
+    {
+        if (reader.m_storage)
+        {
+            for (auto const& node_data : batch) reader.m_storage->append(node_data);
         }
-        else if (token == "$PhysicalNames")
+        else
         {
-            std::string physical_name;
+            reader.nodal_data.insert(end(reader.nodal_data), std::begin(batch), std::end(batch));
+        }
 
-            std::int32_t physicalIds;
-            gmsh_file >> physicalIds;
+        // The spilled nodes are also found through their position in the file
+        for (auto const& node_data : batch) reader.m_node_index.append(node_data.id);
+    }
 
-            for (auto i = 0; i < physicalIds; ++i)
+    void begin_elements(std::int64_t const) override
+    {
+        // The physical names precede the elements, so a filter selecting no
+        // group is reported before any element is parsed
+        for (auto const dimension : reader.m_filter.dimensions)
+        {
+            if (dimension < 0 || dimension > 3)
             {
-                std::int32_t dimension, physicalId;
-                gmsh_file >> dimension >> physicalId >> physical_name;
-
-                // Extract the name from the quotes
-                physical_name.erase(std::remove(physical_name.begin(), physical_name.end(), '\"'),
-                                    physical_name.end());
-                physicalGroupMap.emplace(physicalId, physical_name);
+                throw std::domain_error("The element dimension " + std::to_string(dimension) +
+                                        " of the filter is not between 0 and 3");
             }
-            token.clear();
-            gmsh_file >> token;
         }
-        else if (token == "$Nodes")
+        for (auto const& name : reader.m_filter.physical_names)
         {
-            std::int64_t number_of_nodes;
-            gmsh_file >> number_of_nodes;
-            nodal_data.resize(number_of_nodes);
+            auto const& groups = reader.physicalGroupMap;
 
-            for (auto& node : nodal_data)
+            if (std::none_of(begin(groups), end(groups), [&](auto const& group) {
+                    return group.second == name;
+                }))
             {
-                gmsh_file >> node.id >> node.coordinates[0] >> node.coordinates[1] >>
-                    node.coordinates[2];
+                throw std::domain_error("The physical group \"" + name +
+                                        "\" of the filter is not in " + reader.input_file_name);
             }
         }
-        else if (token == "$Elements")
+    }
+
+    bool accept(std::int32_t const type_id, span<std::int32_t const> const tags) override
+    {
+        // Update the total number of partitions on the fly, including the
+        // elements which are not kept
+        for (std::size_t i = 2; i < tags.size(); ++i)
+        {
+            reader.m_partitions = std::max(std::abs(tags[i]), reader.m_partitions);
+        }
+
+        // Shared elements owned outside of the partition range are parsed for
+        // the interfaces since every interface contributes to the numbering
+        return resolve(tags[0], type_id).keep &&
+               (reader.m_filter.keep_owner(tags) || is_shared(tags));
+    }
+
+    void elements(span<element_record const> const batch) override
+    {
+        for (auto const& record : batch)
         {
-            int elementIds;
-            gmsh_file >> elementIds;
+            auto const& tags         = record.tags;
+            auto const& connectivity = record.node_indices;
 
-            for (std::int64_t elementId = 0; elementId < elementIds; elementId++)
+            if (is_shared(tags))
             {
-                int id = 0, numberOfTags = 0, elementTypeId = 0;
+                for (int i = 4; i < tags[2] + 3; ++i)
+                {
+                    auto const owner_sharer = std::make_pair(tags[3], std::abs(tags[i]));
 
-                gmsh_file >> id >> elementTypeId >> numberOfTags;
+                    reader.interfaceElementMap[owner_sharer].insert(std::begin(connectivity),
+                                                                    std::end(connectivity));
+                }
+            }
 
-                auto const numberOfNodes = mapElementData(elementTypeId);
+            if (!reader.m_filter.keep_owner(tags)) continue;
 
-                std::vector<std::int32_t> tags(numberOfTags, 0);
-                std::vector<std::int64_t> node_indices(numberOfNodes, 0);
+            // Spilled elements are only needed until they are appended
+            element elementData(connectivity,
+                                tags,
+                                record.type_id,
+                                record.id,
+                                reader.m_storage ? scratch : *reader.m_arenas.back());
 
-                for (auto& tag : tags)
-                {
-                    gmsh_file >> tag;
-                }
+            // Spill the element to the partition that owns it or move the
+            // element data into the mesh structure
+            if (reader.m_storage)
+            {
+                reader.m_storage->append(elementData, elementData.owner_process());
+            }
+            else
+            {
+                auto& group = resolve(tags[0], record.type_id);
 
-                for (auto& node_index : node_indices)
+                // The group is created by its first element so no empty groups are added
+                if (group.elements == nullptr)
                 {
-                    gmsh_file >> node_index;
+                    group.elements = &reader.meshes[{*group.physical_name, record.type_id}];
                 }
+                group.elements->push_back(std::move(elementData));
+            }
+        }
+        scratch.reset();
+    }
 
-                auto const physicalId = tags[0];
+private:
+    /// Physical group and element type of the parsed elements, resolved on
+    /// the first element so the name lookup and the filter are not repeated
+    struct group
+    {
+        std::string const* physical_name = nullptr;
 
-                element elementData(std::move(node_indices), tags, elementTypeId, id);
+        /// Elements of the group in the mesh, null until the first element
+        std::vector<element>* elements = nullptr;
 
-                // Update the total number of partitions on the fly
-                m_partitions = std::max(elementData.maxProcessId(), m_partitions);
+        bool keep = false;
+    };
 
-                // Copy the element data into the mesh structure
-                meshes[{physicalGroupMap[physicalId], elementTypeId}].push_back(elementData);
+    /// \return true if the element tags share the element between partitions
+    static bool is_shared(span<std::int32_t const> const tags) noexcept
+    {
+        return tags.size() > 3 && tags[2] > 1;
+    }
 
-                if (elementData.isSharedByMultipleProcesses())
-                {
-                    for (int i = 4; i < tags[2] + 3; ++i)
-                    {
-                        auto const owner_sharer = std::make_pair(tags[3], std::abs(tags[i]));
+    /// \return the group of the physical id and element type, which is found
+    /// in a table indexed by both ids unless the physical id is too large
+    group& resolve(std::int32_t const physical_id, std::int32_t const type_id)
+    {
+        constexpr std::int32_t types = HEXAHEDRON125 + 1;
 
-                        auto const& connectivity = elementData.node_indices();
+        bool const dense = 0 <= physical_id && physical_id < max_dense_physical_id &&
+                           0 <= type_id && type_id < types;
 
-                        interfaceElementMap[owner_sharer].insert(std::begin(connectivity),
-                                                                 std::end(connectivity));
-                    }
-                }
-            }
+        if (dense)
+        {
+            auto const slot = static_cast<std::size_t>(physical_id) * types + type_id;
+
+            if (slot >= groups.size()) groups.resize((physical_id + 1) * types);
+
+            auto& entry = groups[slot];
+            if (entry.physical_name == nullptr) entry = make_group(physical_id, type_id);
+            return entry;
         }
+
+        auto const location = sparse_groups.find({physical_id, type_id});
+        if (location != end(sparse_groups)) return location->second;
+
+        return sparse_groups.emplace(std::make_pair(physical_id, type_id),
+                                     make_group(physical_id, type_id))
+            .first->second;
+    }
+
+    group make_group(std::int32_t const physical_id, std::int32_t const type_id) const
+    {
+        group entry;
+        // Map nodes are stable, so the name outlives the builder
+        entry.physical_name = &reader.physicalGroupMap[physical_id];
+        entry.keep          = reader.m_filter.keep(*entry.physical_name, type_id);
+        return entry;
     }
-    std::cout << std::string(2, ' ') << "A total number of " << m_partitions
-              << " partitions were found\n";
+
+private:
+    mesh_reader const& reader;
+
+    /// Physical ids in the dense table, which has a row for each physical id
+    static constexpr std::int32_t max_dense_physical_id = 1 << 12;
+
+    /// Groups indexed by physical id and element type
+    std::vector<group> groups;
+
+    /// Groups with a physical id outside of the dense table
+    std::map<std::pair<std::int32_t, std::int32_t>, group> sparse_groups;
+
+    /// Arena for the elements spilled to the out-of-core storage
+    monotonic_arena scratch;
+};
+
+void mesh_reader::parse(std::string const& file_name)
+{
+    builder mesh_builder(*this);
+
+    m_parser.parse(file_name, mesh_builder);
+}
+
+void mesh_reader::load(std::string const& section) const
+{
+    // Each section is only parsed once and eagerly parsed readers have none left
+    if (m_unparsed.erase(section) == 0) return;
+
+    std::ifstream gmsh_file(input_file_name);
+    gmsh_file.seekg(m_index.offset(section));
+
+    builder mesh_builder(*this);
+
+    m_parser.parse_section(gmsh_file, mesh_builder);
+}
+
+void mesh_reader::reload()
+{
+    if (m_storage || m_index.sections().empty())
+    {
+        throw std::domain_error("Only a mesh read on demand from a single file can be reloaded");
+    }
+
+    m_index = gmsh_index(input_file_name);
+
+    // Clear the containers while keeping their capacity for the new parse
+    nodal_data.clear();
+    m_node_index.clear();
+    for (auto& mesh : meshes) mesh.second.clear();
+
+    // The element storage of the previous parse is reused unless it is shared
+    // with a copy of the reader whose elements may still be in the arena
+    m_arenas.resize(1);
+    if (m_arenas.front().use_count() > 1)
+    {
+        m_arenas.front() = std::make_shared<monotonic_arena>();
+    }
+    else
+    {
+        m_arenas.front()->reset();
+    }
+
+    interfaceElementMap.clear();
+    physicalGroupMap.clear();
+    m_partitions = 1;
+
+    m_unparsed.clear();
+    for (auto const& section : m_index.sections())
+    {
+        m_unparsed.insert(section.first);
+    }
+    load("$MeshFormat");
+}
+
+void mesh_reader::load_elements() const
+{
+    // The elements are grouped by their physical names
+    load("$PhysicalNames");
+
+    if (m_unparsed.count("$Elements") == 0) return;
+
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    load("$Elements");
+
+    // Remove the groups emptied by a reload which are not in the new mesh
+    for (auto mesh = begin(meshes); mesh != end(meshes);)
+    {
+        mesh = mesh->second.empty() ? meshes.erase(mesh) : std::next(mesh);
+    }
+
+    log_stream() << std::string(2, ' ') << "A total number of " << m_partitions
+                 << " partitions were found\n";
 
     auto const end = std::chrono::high_resolution_clock::now();
 
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Mesh data structure filled in " << elapsed_seconds.count() << "s\n";
+    log_stream() << "Mesh data structure filled in " << elapsed_seconds.count() << "s\n";
 }
 
-int mesh_reader::mapElementData(int const elementTypeId)
+void mesh_reader::assemble(std::vector<std::string> const& input_file_names)
 {
-    // Return the number of local nodes per element
-    switch (elementTypeId)
-    {
-        case LINE2: return 2; break;
-        case TRIANGLE3: return 3; break;
-        case QUADRILATERAL4: return 4; break;
-        case TETRAHEDRON4: return 4; break;
-        case HEXAHEDRON8: return 8; break;
-        case PRISM6: return 6; break;
-        case PYRAMID5: return 5; break;
-        case LINE3: return 3; break;
-        case TRIANGLE6: return 6; break;
-        case QUADRILATERAL9: return 9; break;
-        case TETRAHEDRON10: return 10; break;
-        case HEXAHEDRON27: return 27; break;
-        case PRISM18: return 18; break;
-        case PYRAMID14: return 14; break;
-        case POINT: return 1; break;
-        case QUADRILATERAL8: return 8; break;
-        case HEXAHEDRON20: return 20; break;
-        case PRISM15: return 15; break;
-        case PYRAMID13: return 13; break;
-        case TRIANGLE9: return 19; break;
-        case TRIANGLE10: return 10; break;
-        case TRIANGLE12: return 12; break;
-        case TRIANGLE15: return 15; break;
-        case TRIANGLE15_IC: return 15; break;
-        case TRIANGLE21: return 21; break;
-        case EDGE4: return 4; break;
-        case EDGE5: return 5; break;
-        case EDGE6: return 6; break;
-        case TETRAHEDRON20: return 20; break;
-        case TETRAHEDRON35: return 35; break;
-        case TETRAHEDRON56: return 56; break;
-        case HEXAHEDRON64: return 64; break;
-        case HEXAHEDRON125: return 125; break;
-        default:
-            throw std::domain_error("The elementTypeId " + std::to_string(elementTypeId) +
-                                    " is not implemented");
-    }
-    return -1;
+    scoped_timer const timer("assemble");
+
+    // Each partition file is parsed into a separate fragment of the mesh
+    std::vector<mesh_reader> fragments(input_file_names.size(), *this);
+
+    // Each fragment is parsed by its own thread into its own arena
+    for (auto& fragment : fragments)
+    {
+        fragment.m_arenas = {std::make_shared<monotonic_arena>()};
+    }
+
+    parallel_tasks(fragments.size(), [&](std::size_t const i) {
+        scoped_timer const timer("parse fragment", static_cast<std::int32_t>(i));
+        fragments[i].parse(input_file_names[i]);
+    });
+
+    // The partition files contain the nodes referenced by their elements,
+    // so the nodes on a partition interface appear in multiple files
+    nodal_data.clear();
+
+    for (auto const& fragment : fragments)
+    {
+        nodal_data.insert(end(nodal_data),
+                          begin(fragment.nodal_data),
+                          end(fragment.nodal_data));
+
+        physicalGroupMap.insert(begin(fragment.physicalGroupMap), end(fragment.physicalGroupMap));
+
+        m_partitions = std::max(m_partitions, fragment.m_partitions);
+    }
+
+    std::stable_sort(begin(nodal_data), end(nodal_data), [](auto const& left, auto const& right) {
+        return left.id < right.id;
+    });
+
+    // The copies of a node must agree, otherwise the files are not partitions
+    // of the same mesh
+    nodal_data.erase(std::unique(begin(nodal_data),
+                                 end(nodal_data),
+                                 [&](auto const& left, auto const& right) {
+                                     if (left.id != right.id) return false;
+
+                                     if (left.coordinates != right.coordinates)
+                                     {
+                                         throw std::domain_error(
+                                             "The partition files of " + input_file_name +
+                                             " have different coordinates for the node " +
+                                             std::to_string(left.id));
+                                     }
+                                     return true;
+                                 }),
+                     end(nodal_data));
+
+    m_node_index.clear();
+    m_node_index.reserve(nodal_data.size());
+
+    for (auto const& node : nodal_data) m_node_index.append(node.id);
+
+    // Ghost elements appear in the file of each partition they are shared
+    // with, so the elements are merged in global id order without duplicates
+    for (auto& fragment : fragments)
+    {
+        for (auto& mesh : fragment.meshes)
+        {
+            auto& elements = meshes[mesh.first];
+            std::move(begin(mesh.second), end(mesh.second), std::back_inserter(elements));
+        }
+
+        for (auto& interface : fragment.interfaceElementMap)
+        {
+            interfaceElementMap[interface.first].insert(begin(interface.second),
+                                                        end(interface.second));
+        }
+
+        // The moved elements keep their storage in the arena of the fragment
+        m_arenas.insert(end(m_arenas), begin(fragment.m_arenas), end(fragment.m_arenas));
+    }
+
+    for (auto& mesh : meshes)
+    {
+        auto& elements = mesh.second;
+
+        std::stable_sort(begin(elements), end(elements), [](auto const& left, auto const& right) {
+            return left.id() < right.id();
+        });
+
+        elements.erase(std::unique(begin(elements),
+                                   end(elements),
+                                   [](auto const& left, auto const& right) {
+                                       return left.id() == right.id();
+                                   }),
+                       end(elements));
+
+        for (auto const& element : elements)
+        {
+            for (auto const node_id : element.node_indices())
+            {
+                if (!m_node_index.contains(node_id))
+                {
+                    throw std::domain_error("Node " + std::to_string(node_id) +
+                                            " is missing from the partition files");
+                }
+            }
+        }
+    }
 }
 
 void mesh_reader::checkSupportedGmsh(float const gmshVersion)
@@ -196,81 +598,321 @@ void mesh_reader::checkSupportedGmsh(float const gmshVersion)
     }
 }
 
-void mesh_reader::write(bool const print_indices) const
+std::int64_t mesh_reader::merge_coincident_nodes(double const tolerance)
 {
-    for (int partition = 0; partition < m_partitions; ++partition)
+    scoped_timer const timer("merge nodes");
+
+    if (m_storage)
     {
-        Mesh process_mesh;
+        throw std::domain_error("Nodes cannot be merged for an out-of-core mesh");
+    }
 
-        // Find all of the elements which belong to this process
-        for (auto const& mesh : meshes)
+    load("$Nodes");
+    load_elements();
+
+    auto const representative = find_coincident_nodes(nodal_data, tolerance);
+
+    std::int64_t merged = 0;
+    for (std::size_t i = 0; i < representative.size(); ++i)
+    {
+        if (representative[i] != static_cast<std::int64_t>(i)) ++merged;
+    }
+
+    log_stream() << std::string(2, ' ') << "A total number of " << merged
+                 << " coincident nodes were merged\n";
+
+    if (merged == 0) return merged;
+
+    // Map every node onto the new number of its representative, leaving the
+    // nodes untouched until the connectivity is remapped
+    std::vector<std::int64_t> renumbered(nodal_data.size());
+
+    std::int64_t retained = 0;
+    for (std::size_t i = 0; i < nodal_data.size(); ++i)
+    {
+        if (representative[i] == static_cast<std::int64_t>(i))
         {
-            // Copy the elements into the process mesh
-            for (auto const& element : mesh.second)
+            renumbered[i] = ++retained;
+        }
+        else
+        {
+            renumbered[i] = renumbered[representative[i]];
+        }
+    }
+
+    // Check that every element refers to a known node before the first
+    // element is changed, so a missing node leaves the mesh as it was
+    for (auto const& mesh : meshes)
+    {
+        auto const& elements = mesh.second;
+
+        parallel_for(elements.size(), [&](std::int64_t const first, std::int64_t const last) {
+            for (auto i = first; i < last; ++i)
             {
-                if (element.isOwnedByProcess(partition + 1))
+                for (auto const node : elements[i].node_indices()) m_node_index.position(node);
+            }
+        });
+    }
+
+    decltype(interfaceElementMap) interfaces;
+    for (auto const& interface : interfaceElementMap)
+    {
+        auto& interface_nodes = interfaces[interface.first];
+        for (auto const node : interface.second)
+        {
+            interface_nodes.insert(renumbered[m_node_index.position(node)]);
+        }
+    }
+
+    for (auto& mesh : meshes)
+    {
+        auto& elements = mesh.second;
+
+        parallel_for(elements.size(), [&](std::int64_t const first, std::int64_t const last) {
+            for (auto i = first; i < last; ++i)
+            {
+                for (auto& node : elements[i].node_indices())
                 {
-                    process_mesh[mesh.first].push_back(element);
+                    node = renumbered[m_node_index.position(node)];
                 }
             }
-        }
+        });
+    }
+    interfaceElementMap = std::move(interfaces);
+
+    // Compact the remaining nodes, which are numbered consecutively from one
+    for (std::size_t i = 0; i < nodal_data.size(); ++i)
+    {
+        if (representative[i] != static_cast<std::int64_t>(i)) continue;
+
+        auto const position = renumbered[i] - 1;
+
+        nodal_data[position]    = nodal_data[i];
+        nodal_data[position].id = renumbered[i];
+    }
+    nodal_data.resize(retained);
+
+    m_node_index.clear();
+    for (auto const& node : nodal_data) m_node_index.append(node.id);
+
+    return merged;
+}
 
-        auto local_global_mapping = fillLocalToGlobalMap(process_mesh);
+memory_usage mesh_reader::memory() const
+{
+    auto usage = m_write_memory;
+
+    usage.nodes    = nodal_data.capacity() * sizeof(node) + m_node_index.memory_bytes();
+    usage.elements = mesh_bytes(meshes);
+
+    for (auto const& arena : m_arenas) usage.elements += arena->capacity();
+
+    usage.interfaces = 0;
+    for (auto const& interface : interfaceElementMap)
+    {
+        usage.interfaces += tree_node_bytes + sizeof(interface) +
+                            interface.second.size() * (tree_node_bytes + sizeof(std::int64_t));
+    }
+    return usage;
+}
+
+void mesh_reader::write(bool const print_indices, conversion_cache* cache) const
+{
+    load("$Nodes");
+    load_elements();
 
-        auto local_nodes = fillLocalNodeList(local_global_mapping);
+    auto const max_node_id = m_node_index.max_id();
 
-        if (useLocalNodalConnectivity)
+    auto const fits_32_bits = max_node_id <= std::numeric_limits<std::int32_t>::max();
+
+    if (m_format.index_width == 32 && !fits_32_bits)
+    {
+        throw std::domain_error("The node ids of " + input_file_name + " up to " +
+                                std::to_string(max_node_id) + " do not fit into 32 bit indices");
+    }
+
+    auto const use_32_bits = m_format.index_width == 32 ||
+                             (m_format.index_width == 0 && fits_32_bits);
+
+    auto const first_partition = std::max(m_filter.first_partition, 0);
+    auto const last_partition  = std::min(m_filter.last_partition, m_partitions - 1);
+
+    if (first_partition > last_partition)
+    {
+        log_stream() << std::string(2, ' ') << "Warning: the partition range does not include "
+                     << "any of the " << m_partitions << " partitions of " << input_file_name
+                     << "\n";
+    }
+
+    for (int partition = first_partition; partition <= last_partition; ++partition)
+    {
+        if (use_32_bits)
         {
-            reorderLocalMesh(process_mesh, local_global_mapping);
+            write_partition<std::int32_t>(partition, print_indices, cache);
         }
-
-        // Check if this local mesh needs to be converted to zero based indexing
-        // then correct the nodal connectivities, the mappings and the nodal and
-        // element ids of the data structures
-        if (useZeroBasedIndexing)
+        else
         {
-            std::transform(begin(local_global_mapping),
-                           end(local_global_mapping),
-                           begin(local_global_mapping),
-                           [](auto const value) { return value - 1; });
+            write_partition<std::int64_t>(partition, print_indices, cache);
+        }
+    }
+}
 
-            for (auto& localNode : local_nodes)
-            {
-                --localNode.id;
-            }
+void mesh_reader::set_output_format(output_format const& format)
+{
+    if (format.index_width != 0 && format.index_width != 32 && format.index_width != 64)
+    {
+        throw std::domain_error("The index width " + std::to_string(format.index_width) +
+                                " is not 32 or 64 bits");
+    }
+    if (!compression_available(format.compress))
+    {
+        throw std::domain_error("The compression method is not available in this build");
+    }
+    if (format.significant_digits < 0 || format.significant_digits > 17)
+    {
+        throw std::domain_error("The number of significant digits " +
+                                std::to_string(format.significant_digits) +
+                                " is not 0 (shortest) or between 1 and 17");
+    }
+    m_format = format;
+}
 
-            for (auto& mesh : process_mesh)
+template <typename Index>
+void mesh_reader::write_partition(int const partition,
+                                  bool const print_indices,
+                                  conversion_cache* cache) const
+{
+    scoped_timer const partition_timer("write partition", partition);
+
+    auto process_mesh = m_storage ? load_partition<Index>(partition) : partition_mesh<Index>{};
+
+    {
+        scoped_timer const timer("gather elements");
+
+        // Find all of the elements which belong to this process
+        for (auto const& mesh : meshes)
+        {
+            basic_element_block<Index>* block = nullptr;
+
+            // Copy the connectivity into the block of the group
+            for (auto const& element : mesh.second)
             {
-                for (auto& element : mesh.second)
+                if (element.isOwnedByProcess(partition + 1))
                 {
-                    element.convertToZeroBasedIndexing();
+                    if (block == nullptr)
+                    {
+                        block = &process_mesh.emplace(mesh.first, mesh.first.second).first->second;
+                    }
+                    block->push_back(element);
                 }
             }
         }
+    }
+
+    if (memory_accounting_enabled())
+    {
+        m_write_memory.partition_elements = std::max(m_write_memory.partition_elements,
+                                                     mesh_bytes(process_mesh));
+    }
+
+    auto const local_global_mapping = fillLocalToGlobalMap(process_mesh);
 
-        write_json(process_mesh,
-                   local_global_mapping,
-                   local_nodes,
-                   partition,
-                   m_partitions > 1,
-                   print_indices);
+    auto const local_nodes = fillLocalNodeList(local_global_mapping);
 
-        std::cout << std::string(2, ' ') << "Finished writing out JSON file for mesh partition "
-                  << partition << "\n";
+    if (useLocalNodalConnectivity)
+    {
+        reorderLocalMesh(process_mesh, local_global_mapping);
     }
+
+    auto const content = write_json(process_mesh,
+                                    local_global_mapping,
+                                    local_nodes,
+                                    partition,
+                                    m_partitions > 1,
+                                    print_indices);
+
+    scoped_timer const write_timer("file write");
+
+    auto output_file_name = input_file_name.substr(0, input_file_name.find_last_of('.')) +
+                            ".mesh";
+
+    if (m_partitions > 1) output_file_name += std::to_string(partition);
+
+    output_file_name += compression_suffix(m_format.compress);
+
+    auto written = true;
+
+    if (cache != nullptr)
+    {
+        written = cache->write(output_file_name,
+                               m_format.compress == compression::none
+                                   ? content
+                                   : compress(content, m_format.compress));
+    }
+    else if (m_format.compress != compression::none)
+    {
+        std::ofstream writer(output_file_name, std::ios::binary);
+
+        // The compressed blocks are written while the next blocks are compressed
+        block_compressor compressor(m_format.compress,
+                                    [&](std::string const& block) { writer << block; });
+        compressor.write(content);
+        compressor.finish();
+    }
+    else
+    {
+        std::fstream writer;
+        writer.open(output_file_name, std::ios::out);
+        writer << content;
+        writer.close();
+    }
+
+    log_stream() << std::string(2, ' ')
+                 << (written ? "Finished writing out" : "Kept unchanged")
+                 << " JSON file for mesh partition " << partition << "\n";
+
+    if (m_storage) m_storage->release_nodes();
 }
 
-std::vector<std::int64_t> mesh_reader::fillLocalToGlobalMap(Mesh const& process_mesh) const
+template <typename Index>
+mesh_reader::partition_mesh<Index> mesh_reader::load_partition(int const partition) const
 {
-    std::vector<std::int64_t> local_global_mapping;
+    scoped_timer const timer("load partition");
+
+    if (m_storage->partition_bytes(partition + 1) > m_storage->memory_budget())
+    {
+        log_stream() << std::string(2, ' ') << "Warning: mesh partition " << partition
+                     << " is larger than the memory budget\n";
+    }
+
+    partition_mesh<Index> process_mesh;
+
+    m_storage->for_each_element(partition + 1, [&](element&& element_data) {
+        auto const& physical_name = physicalGroupMap.at(element_data.physicalId());
+
+        process_mesh
+            .emplace(std::make_pair(physical_name, element_data.typeId()), element_data.typeId())
+            .first->second.push_back(element_data);
+    });
+
+    return process_mesh;
+}
+
+template <typename Index>
+std::vector<Index>
+mesh_reader::fillLocalToGlobalMap(partition_mesh<Index> const& process_mesh) const
+{
+    scoped_timer const timer("local to global");
+
+    std::vector<Index> local_global_mapping;
 
     for (auto const& mesh : process_mesh)
     {
-        for (auto const& element : mesh.second)
-        {
-            auto const& nodes = element.node_indices();
-            std::copy(std::begin(nodes), std::end(nodes), std::back_inserter(local_global_mapping));
-        }
+        auto const connectivity = mesh.second.connectivity();
+
+        local_global_mapping.insert(std::end(local_global_mapping),
+                                    connectivity.begin(),
+                                    connectivity.end());
     }
 
     // Sort and remove duplicates
@@ -282,60 +924,81 @@ std::vector<std::int64_t> mesh_reader::fillLocalToGlobalMap(Mesh const& process_
     return local_global_mapping;
 }
 
-void mesh_reader::reorderLocalMesh(Mesh& process_mesh,
-                                   std::vector<std::int64_t> const& local_global_mapping) const
+template <typename Index>
+void mesh_reader::reorderLocalMesh(partition_mesh<Index>& process_mesh,
+                                   std::vector<Index> const& local_global_mapping) const
 {
+    scoped_timer const timer("reorder");
+
     for (auto& mesh : process_mesh)
     {
-        for (auto& element : mesh.second)
+        for (auto& node : mesh.second.connectivity())
         {
-            for (auto& node : element.node_indices())
-            {
-                auto const found = std::lower_bound(std::begin(local_global_mapping),
-                                                    std::end(local_global_mapping),
-                                                    node);
+            auto const found = std::lower_bound(std::begin(local_global_mapping),
+                                                std::end(local_global_mapping),
+                                                node);
 
-                // Reset the node value to that inside the local ordering with
-                // the default of one based ordering
-                node = std::distance(local_global_mapping.begin(), found) + 1;
-            }
+            // Reset the node value to that inside the local ordering with
+            // the default of one based ordering
+            node = std::distance(local_global_mapping.begin(), found) + 1;
         }
     }
 }
 
+template <typename Index>
 std::vector<node>
-mesh_reader::fillLocalNodeList(std::vector<std::int64_t> const& local_global_mapping) const
+mesh_reader::fillLocalNodeList(std::vector<Index> const& local_global_mapping) const
 {
+    scoped_timer const timer("gather nodes");
+
     std::vector<node> local_nodal_data;
     local_nodal_data.reserve(local_global_mapping.size());
 
-    for (auto const& node_index : local_global_mapping)
+    if (m_storage)
+    {
+        // Out-of-core nodes are gathered from the memory mapped coordinate
+        // file, which holds the nodes in the order they were parsed
+        auto const nodes = m_storage->nodes();
+
+        for (auto const& node_id : local_global_mapping)
+        {
+            local_nodal_data.emplace_back(nodes[m_node_index.position(node_id)]);
+        }
+    }
+    else
     {
-        local_nodal_data.emplace_back(nodal_data[node_index - 1]);
+        for (auto const& node_id : local_global_mapping)
+        {
+            local_nodal_data.emplace_back(nodal_data[m_node_index.position(node_id)]);
+        }
+    }
+
+    if (m_format.single_precision)
+    {
+        for (auto& local_node : local_nodal_data)
+        {
+            for (auto& xyz : local_node.coordinates) xyz = static_cast<float>(xyz);
+        }
     }
     return local_nodal_data;
 }
 
-void mesh_reader::write_json(Mesh const& process_mesh,
-                             std::vector<std::int64_t> const& localToGlobalMapping,
-                             std::vector<node> const& nodalCoordinates,
-                             int const partition_number,
-                             bool const is_decomposed,
-                             bool const print_indices) const
+template <typename Index>
+std::string mesh_reader::write_json(partition_mesh<Index> const& process_mesh,
+                                    std::vector<Index> const& localToGlobalMapping,
+                                    std::vector<node> const& nodalCoordinates,
+                                    int const partition_number,
+                                    bool const is_decomposed,
+                                    bool const print_indices) const
 {
-    // Write out each file to Json format
-    Json::Value event;
-
-    std::string output_file_name = input_file_name.substr(0, input_file_name.find_last_of('.')) +
-                                   ".mesh";
+    scoped_timer const timer("serialise");
 
-    if (is_decomposed)
-    {
-        output_file_name += std::to_string(partition_number);
-    }
+    // The partition data is one based and zero based indexing is applied
+    // to the nodal connectivities, the mappings and the ids as they are written
+    Index const base = useZeroBasedIndexing ? 1 : 0;
 
-    std::fstream writer;
-    writer.open(output_file_name, std::ios::out);
+    // Write out each file to Json format
+    Json::Value event;
 
     // Write out the nodal coordinates
     Json::Value nodeGroup;
@@ -343,18 +1006,27 @@ void mesh_reader::write_json(Mesh const& process_mesh,
 
     for (auto const& node : nodalCoordinates)
     {
-        Json::Value coordinates(Json::arrayValue);
-        for (auto const& xyz : node.coordinates)
+        if (m_format.compact)
+        {
+            for (auto const& xyz : node.coordinates) nodeGroupCoordinates.append(xyz);
+        }
+        else
         {
-            coordinates.append(Json::Value(xyz));
+            Json::Value coordinates(Json::arrayValue);
+            for (auto const& xyz : node.coordinates)
+            {
+                coordinates.append(Json::Value(xyz));
+            }
+            nodeGroupCoordinates.append(coordinates);
         }
-        nodeGroupCoordinates.append(coordinates);
 
         if (print_indices)
         {
-            nodeGroup["Indices"].append(node.id);
+            nodeGroup["Indices"].append(node.id - base);
         }
     }
+    if (m_format.compact) nodeGroup["Stride"] = 3;
+
     event["Nodes"].append(nodeGroup);
 
     for (auto const& mesh : process_mesh)
@@ -362,18 +1034,34 @@ void mesh_reader::write_json(Mesh const& process_mesh,
         Json::Value elementGroup;
         auto& elementGroupNodalConnectivity = elementGroup["NodalConnectivity"];
 
-        for (auto const& element_data : mesh.second)
+        if (m_format.compact)
         {
-            Json::Value connectivity(Json::arrayValue);
-
-            for (auto const& node : element_data.node_indices())
+            for (auto const node : mesh.second.connectivity())
             {
-                connectivity.append(node);
+                elementGroupNodalConnectivity.append(node - base);
             }
+            elementGroup["Stride"] = static_cast<int>(mesh.second.stride());
+        }
+        else
+        {
+            visit_element_type(mesh.second.type_id(), [&](auto const type) {
+                for (auto const& row : mesh.second.template rows<decltype(type)::id>())
+                {
+                    Json::Value connectivity(Json::arrayValue);
 
-            elementGroupNodalConnectivity.append(connectivity);
+                    for (auto const& node : row)
+                    {
+                        connectivity.append(node - base);
+                    }
 
-            if (print_indices) elementGroup["Indices"].append(element_data.id());
+                    elementGroupNodalConnectivity.append(connectivity);
+                }
+            });
+        }
+
+        if (print_indices)
+        {
+            for (auto const id : mesh.second.ids()) elementGroup["Indices"].append(id - base);
         }
 
         elementGroup["Name"] = mesh.first.first;
@@ -387,7 +1075,7 @@ void mesh_reader::write_json(Mesh const& process_mesh,
         auto& eventLocalToGlobalMap = event["LocalToGlobalMap"];
         for (auto const& l2g : localToGlobalMapping)
         {
-            eventLocalToGlobalMap.append(l2g);
+            eventLocalToGlobalMap.append(l2g - base);
         }
 
         if (is_feti_format)
@@ -478,8 +1166,14 @@ void mesh_reader::write_json(Mesh const& process_mesh,
             }
         }
     }
-    Json::StyledWriter jsonwriter;
-    writer << jsonwriter.write(event);
-    writer.close();
+    if (memory_accounting_enabled())
+    {
+        m_write_memory.json_document = std::max(m_write_memory.json_document, json_bytes(event));
+    }
+
+    return json_writer(m_format.significant_digits,
+                       m_format.single_precision,
+                       m_format.compact ? json_layout::compact : json_layout::styled)
+        .write(event);
 }
 } // namespace imr
@@ -2,12 +2,23 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "conversion_cache.hpp"
 #include "element.hpp"
+#include "element_block.hpp"
+#include "element_filter.hpp"
+#include "element_type.hpp"
+#include "gmsh_parser.hpp"
+#include "memory_usage.hpp"
+#include "monotonic_arena.hpp"
 #include "node.hpp"
+#include "node_index.hpp"
+#include "out_of_core_storage.hpp"
+#include "output_format.hpp"
 
 namespace imr
 {
@@ -20,45 +31,6 @@ enum class IndexingBase { Zero, One };
 /// Ordering for distribution of mshes
 enum class distributed { feti, interprocess };
 
-/// Gmsh element numbering scheme
-enum ELEMENT_TYPE_ID {
-    // Standard linear elements
-    LINE2 = 1,
-    TRIANGLE3,
-    QUADRILATERAL4,
-    TETRAHEDRON4,
-    HEXAHEDRON8,
-    PRISM6,
-    PYRAMID5,
-    // Quadratic elements
-    LINE3,
-    TRIANGLE6,
-    QUADRILATERAL9, // 4 vertex, 4 edges and 1 face node
-    TETRAHEDRON10,
-    HEXAHEDRON27,
-    PRISM18,
-    PYRAMID14,
-    POINT = 15,
-    QUADRILATERAL8,
-    HEXAHEDRON20,
-    PRISM15,
-    PYRAMID13,
-    TRIANGLE9 = 20,
-    TRIANGLE10,
-    TRIANGLE12,
-    TRIANGLE15,
-    TRIANGLE15_IC, // Incomplete 15 node triangle
-    TRIANGLE21 = 25,
-    EDGE4,
-    EDGE5,
-    EDGE6,
-    TETRAHEDRON20,
-    TETRAHEDRON35,
-    TETRAHEDRON56,
-    HEXAHEDRON64 = 92,
-    HEXAHEDRON125
-};
-
 /// mesh_reader parses Gmsh format and returns the data structures of the mesh
 /// in a json format for easier processing
 class mesh_reader
@@ -66,81 +38,212 @@ class mesh_reader
 public:
     using Mesh = std::map<std::pair<std::string, std::int32_t>, std::vector<element>>;
 
+    /// Elements owned by a partition with the connectivity of each group held
+    /// in a fixed-stride block of the index type \sa output_format
+    template <typename Index>
+    using partition_mesh = std::map<std::pair<std::string, std::int32_t>,
+                                    basic_element_block<Index>>;
+
     using owner_sharer_t = std::pair<std::int32_t, std::int32_t>;
 
 public:
+    /// The constructor only scans the file for the offsets of its sections.
+    /// Each section is parsed on first access, so querying the physical names
+    /// does not parse the nodes or the elements.  The first access is not
+    /// synchronised between threads.
     /// \param File name of gmsh mesh
     /// \param Flag to use local processor ordering or retain global ordering.
     ///        If this is true, then each of the output meshes will have be ordered
     ///        locally and there will be a local to global mapping provided in the
     ///        the mesh file in addition to the nodal connectivity
     /// \param Flag for zero based indexing in nodal coordinates
+    /// \param Elements to keep while parsing, by default all of the elements
     explicit mesh_reader(std::string const& input_file_name,
                          NodalOrdering const ordering,
                          IndexingBase const base,
-                         distributed const distributed_option);
+                         distributed const distributed_option,
+                         element_filter const& filter = {});
+
+    /// Assemble a mesh from the files Gmsh writes for each partition when the
+    /// partitioned mesh is split into one file per partition (name_1.msh,
+    /// name_2.msh, ...).  The files are parsed concurrently and the nodes and
+    /// elements are reconciled using their global ids, resulting in the same
+    /// mesh and outputs as the monolithic file (name.msh).
+    /// \param File names of the gmsh partition meshes
+    /// \sa mesh_reader
+    explicit mesh_reader(std::vector<std::string> const& input_file_names,
+                         NodalOrdering const ordering,
+                         IndexingBase const base,
+                         distributed const distributed_option,
+                         element_filter const& filter = {});
+
+    /// Out-of-core reader for meshes which are larger than the available
+    /// memory.  The nodes and the elements of each partition are spilled to
+    /// temporary files while parsing and each partition is processed
+    /// independently when writing, gathering only its own nodes from the
+    /// memory mapped coordinate file.  The mesh() and nodes() are empty.
+    /// \param memory_budget Approximate maximum number of bytes held in memory
+    /// \sa mesh_reader
+    explicit mesh_reader(std::string const& input_file_name,
+                         NodalOrdering const ordering,
+                         IndexingBase const base,
+                         distributed const distributed_option,
+                         std::size_t const memory_budget,
+                         element_filter const& filter = {});
 
     ~mesh_reader() = default;
 
     /// Return a map of the physical names and the element data.
     /// The physicalIds and the names are given by names().
     /// The value in the map is a list of ElementData objects
-    auto const& mesh() const { return meshes; }
+    auto const& mesh() const
+    {
+        load_elements();
+        return meshes;
+    }
 
     /// Return a list of the coordinates and Ids of the nodes
-    std::vector<node> const& nodes() const { return nodal_data; }
+    std::vector<node> const& nodes() const
+    {
+        load("$Nodes");
+        return nodal_data;
+    }
 
     /// Return the physical names associated with the mesh
-    std::map<std::int32_t, std::string> const& names() const { return physicalGroupMap; }
+    std::map<std::int32_t, std::string> const& names() const
+    {
+        load("$PhysicalNames");
+        return physicalGroupMap;
+    }
+
+    /// Return true if the nodes and the elements are spilled to temporary
+    /// files rather than held by mesh() and nodes()
+    bool out_of_core() const noexcept { return m_storage != nullptr; }
+
+    /// Return the nodes each owning process contributes to the interface with
+    /// a sharing process.  The key is the pair (owner, sharer) of processes
+    auto const& interfaces() const
+    {
+        load_elements();
+        return interfaceElementMap;
+    }
 
     /// Write out a distributed mesh in the Murge format which requires a
     /// local to global mapping for the distributed matrices from a finite
     /// element discretization.  This involves performing a reordering of
     /// each of the element nodal connectivity arrays from the global view
     /// that gmsh outputs and the local processor view that Murge expects.
-    void write(bool const printIndices = true) const;
+    /// Only the partitions in the partition range of the filter are written.
+    /// \param cache If provided, only the output files whose content differs
+    ///        from the manifest of the cache are written
+    void write(bool const printIndices = true, conversion_cache* cache = nullptr) const;
+
+    /// Set the index width and the coordinate precision of the written files
+    void set_output_format(output_format const& format);
+
+    output_format const& format() const noexcept { return m_format; }
+
+    /// Merge the nodes which coincide within a tolerance, for example when a
+    /// mesh is stitched together from multiple Gmsh runs.  The remaining nodes
+    /// are renumbered contiguously and the element connectivities and the
+    /// interfaces are remapped onto the remaining nodes.
+    /// \param tolerance Maximum distance between two coincident nodes
+    /// \return Number of nodes removed by merging
+    std::int64_t merge_coincident_nodes(double const tolerance);
+
+    /// Parse the gmsh file again after it has changed on disk, reusing the
+    /// memory of the previous parse where possible.  The sections are parsed
+    /// on first access as for a newly constructed reader.
+    /// \throw std::domain_error for out-of-core or assembled readers
+    void reload();
+
+    /// Return the bytes held by the nodes, the elements and the interfaces.
+    /// The largest partition copy and JSON document of the last write are
+    /// included if memory accounting was enabled while writing.
+    memory_usage memory() const;
+
+    /// Return the name of the gmsh file the outputs are named after
+    std::string const& file_name() const { return input_file_name; }
 
     /// Return the number of decompositions in the mesh
-    auto numberOfPartitions() const { return m_partitions; }
+    auto numberOfPartitions() const
+    {
+        load_elements();
+        return m_partitions;
+    }
 
 private:
-    /// Provide a reference to the nodes and dimensions that will be populated
-    /// with the correct data based on the elementType
-    /// \param elementTypeId gmsh element number
-    /// \return number of nodes for the element
-    int mapElementData(int const elementTypeId);
+    class builder;
 
     /// Check the version of gmsh is support otherwise print out a warning
     /// \param gmshVersion
-    void checkSupportedGmsh(float const gmshVersion);
+    static void checkSupportedGmsh(float const gmshVersion);
+
+    /// Parse a section of the gmsh file if it has not been parsed yet
+    /// \param section Name of the section, e.g. "$Nodes"
+    void load(std::string const& section) const;
+
+    /// Parse the elements (and the physical names they are grouped by)
+    void load_elements() const;
 
     /// This method fills the datastructures \sa element \sa node
     void fillMesh();
 
+    /// Parse a gmsh file into the datastructures \sa fillMesh
+    void parse(std::string const& file_name);
+
+    /// Parse each of the partition files concurrently and merge the resulting
+    /// nodes, elements and interfaces into the datastructures
+    void assemble(std::vector<std::string> const& input_file_names);
+
+    /// Write out a single partition with node indices of the index type
+    template <typename Index>
+    void write_partition(int const partition,
+                         bool const print_indices,
+                         conversion_cache* cache) const;
+
     /// Return the local to global mapping for the nodal connectivities
-    std::vector<std::int64_t> fillLocalToGlobalMap(Mesh const& process_mesh) const;
+    template <typename Index>
+    std::vector<Index> fillLocalToGlobalMap(partition_mesh<Index> const& process_mesh) const;
 
     /// Reorder the mesh to for each process
-    void reorderLocalMesh(Mesh& processMesh,
-                          std::vector<std::int64_t> const& local_global_mapping) const;
+    template <typename Index>
+    void reorderLocalMesh(partition_mesh<Index>& processMesh,
+                          std::vector<Index> const& local_global_mapping) const;
 
     /// Gather the local process nodal coordinates using the local to global mapping.
     /// This is required to reduce the number of coordinates for each process.
     /// \sa writeInJsonFormat
-    std::vector<node>
-    fillLocalNodeList(std::vector<std::int64_t> const& local_global_mapping) const;
+    template <typename Index>
+    std::vector<node> fillLocalNodeList(std::vector<Index> const& local_global_mapping) const;
+
+    /// Read the elements owned by a partition back from the out-of-core storage
+    template <typename Index>
+    partition_mesh<Index> load_partition(int const partition) const;
 
-    void write_json(Mesh const& process_mesh,
-                    std::vector<std::int64_t> const& local_global_mapping,
-                    std::vector<node> const& nodalCoordinates,
-                    int const process_number,
-                    bool const is_distributed,
-                    bool const printIndices) const;
+    /// Return the JSON document of a mesh partition
+    template <typename Index>
+    std::string write_json(partition_mesh<Index> const& process_mesh,
+                           std::vector<Index> const& local_global_mapping,
+                           std::vector<node> const& nodalCoordinates,
+                           int const process_number,
+                           bool const is_distributed,
+                           bool const printIndices) const;
 
 private:
-    std::vector<node> nodal_data;
+    // The mesh data is mutable since the sections are parsed on first access
+
+    /// Storage of the parsed elements, which is declared before the elements
+    /// so the elements are destroyed first
+    mutable std::vector<std::shared_ptr<monotonic_arena>> m_arenas{
+        std::make_shared<monotonic_arena>()};
+
+    mutable std::vector<node> nodal_data;
 
-    Mesh meshes;
+    /// Position of each node id in the nodal data
+    mutable node_index m_node_index;
+
+    mutable Mesh meshes;
 
     /**
      * Key:
@@ -148,9 +251,9 @@ private:
      * pair.second: process that shares the element
      * Value:       node ids of the interface element
      */
-    std::map<owner_sharer_t, std::set<std::int64_t>> interfaceElementMap;
+    mutable std::map<owner_sharer_t, std::set<std::int64_t>> interfaceElementMap;
 
-    std::map<std::int32_t, std::string> physicalGroupMap;
+    mutable std::map<std::int32_t, std::string> physicalGroupMap;
 
     /// File name of gmsh file
     std::string input_file_name;
@@ -161,6 +264,26 @@ private:
     /// Output in FETI format
     bool is_feti_format = true;
 
-    int m_partitions = 1;
+    /// Elements to keep while parsing
+    element_filter m_filter;
+
+    /// Temporary files holding the nodes and elements for out-of-core mode
+    std::shared_ptr<out_of_core_storage> m_storage;
+
+    /// Section offsets of the gmsh file
+    gmsh_index m_index;
+
+    /// Parser whose buffers are reused for each of the sections
+    mutable gmsh_parser m_parser;
+
+    /// Sections of the gmsh file which have not been parsed yet
+    mutable std::set<std::string> m_unparsed;
+
+    mutable int m_partitions = 1;
+
+    /// Largest partition copy and JSON document while writing
+    mutable memory_usage m_write_memory;
+
+    output_format m_format;
 };
 } // namespace imr
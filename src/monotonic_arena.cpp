@@ -0,0 +1,55 @@
+
+#include "monotonic_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace imr
+{
+monotonic_arena::monotonic_arena(std::size_t const block_size)
+    : m_block_size(std::max<std::size_t>(block_size, 64))
+{
+}
+
+void* monotonic_arena::allocate(std::size_t const bytes, std::size_t const alignment)
+{
+    for (; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+    {
+        auto const& current = m_blocks[m_current];
+
+        // Round the offset up to the alignment of the type
+        auto const address = reinterpret_cast<std::uintptr_t>(current.data.get()) + m_offset;
+        auto const padding = (alignment - address % alignment) % alignment;
+
+        if (m_offset + padding + bytes <= current.size)
+        {
+            m_offset += padding + bytes;
+            return current.data.get() + m_offset - bytes;
+        }
+    }
+
+    // Blocks are aligned for any fundamental type, and requests larger than a
+    // block are given a block of their own
+    auto const size = std::max(m_block_size, bytes);
+
+    m_blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+
+    m_current = m_blocks.size() - 1;
+    m_offset  = bytes;
+
+    return m_blocks.back().data.get();
+}
+
+void monotonic_arena::reset() noexcept
+{
+    m_current = 0;
+    m_offset  = 0;
+}
+
+std::size_t monotonic_arena::capacity() const noexcept
+{
+    std::size_t bytes = 0;
+    for (auto const& block : m_blocks) bytes += block.size;
+    return bytes;
+}
+} // namespace imr
@@ -0,0 +1,106 @@
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace imr
+{
+/// monotonic_arena hands out memory from large blocks and releases it only
+/// all at once, so the storage of each parsed element costs no allocator
+/// call.  An arena is not synchronised and is used by a single thread.
+class monotonic_arena
+{
+public:
+    /// \param block_size Bytes of each block taken from the heap
+    explicit monotonic_arena(std::size_t const block_size = 1 << 20);
+
+    monotonic_arena(monotonic_arena const&) = delete;
+    monotonic_arena& operator=(monotonic_arena const&) = delete;
+
+    /// \return uninitialised memory which is valid until the arena is reset
+    void* allocate(std::size_t const bytes, std::size_t const alignment);
+
+    /// Make the memory of the blocks available again while keeping the blocks
+    void reset() noexcept;
+
+    /// \return the bytes held by the blocks
+    std::size_t capacity() const noexcept;
+
+    /// \return the number of blocks taken from the heap
+    std::size_t blocks() const noexcept { return m_blocks.size(); }
+
+private:
+    struct block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::size_t m_block_size;
+
+    std::vector<block> m_blocks;
+
+    /// Block being allocated from and the offset of its free memory
+    std::size_t m_current = 0;
+    std::size_t m_offset  = 0;
+};
+
+/// arena_allocator allocates from a monotonic_arena, or from the heap when it
+/// has no arena.  Moving a container moves its memory along with the arena,
+/// while a copy of a container allocates from the heap so the copy remains
+/// valid after the arena is reset.
+template <typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+public:
+    arena_allocator() noexcept = default;
+
+    arena_allocator(monotonic_arena& arena) noexcept : m_arena(&arena) {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other) noexcept : m_arena(other.arena())
+    {
+    }
+
+    T* allocate(std::size_t const size)
+    {
+        if (m_arena == nullptr) return static_cast<T*>(::operator new(size * sizeof(T)));
+
+        return static_cast<T*>(m_arena->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* const data, std::size_t) noexcept
+    {
+        if (m_arena == nullptr) ::operator delete(data);
+    }
+
+    arena_allocator select_on_container_copy_construction() const noexcept { return {}; }
+
+    monotonic_arena* arena() const noexcept { return m_arena; }
+
+private:
+    monotonic_arena* m_arena = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(arena_allocator<T> const& left, arena_allocator<U> const& right) noexcept
+{
+    return left.arena() == right.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(arena_allocator<T> const& left, arena_allocator<U> const& right) noexcept
+{
+    return !(left == right);
+}
+} // namespace imr
@@ -0,0 +1,132 @@
+
+#include "node_index.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace imr
+{
+namespace
+{
+/// Id of an empty bucket
+constexpr std::int64_t empty_id = std::numeric_limits<std::int64_t>::min();
+}
+
+void node_index::clear() noexcept
+{
+    m_first_id   = 1;
+    m_size       = 0;
+    m_max_id     = 0;
+    m_reserved   = 0;
+    m_contiguous = true;
+
+    std::fill(begin(m_table), end(m_table), std::make_pair(empty_id, std::int64_t{-1}));
+}
+
+void node_index::reserve(std::int64_t const number_of_nodes)
+{
+    m_reserved = std::max(m_reserved, number_of_nodes);
+
+    // The table is only built for sparse ids
+    if (m_contiguous) return;
+
+    // Keep the load factor at or below one half
+    auto bits = 4;
+    while ((std::int64_t{1} << bits) < 2 * number_of_nodes) ++bits;
+
+    if (bits <= m_bits) return;
+
+    auto const entries = std::move(m_table);
+
+    m_bits = bits;
+    m_table.assign(std::size_t{1} << m_bits, {empty_id, -1});
+
+    for (auto const& entry : entries)
+    {
+        if (entry.first != empty_id) insert(entry.first, entry.second);
+    }
+}
+
+void node_index::append(std::int64_t const id)
+{
+    if (m_size == 0 && m_contiguous) m_first_id = id;
+
+    if (m_contiguous && id != m_first_id + m_size) build_table();
+
+    if (!m_contiguous)
+    {
+        if (2 * (m_size + 1) > static_cast<std::int64_t>(m_table.size()))
+        {
+            reserve(2 * (m_size + 1));
+        }
+        insert(id, m_size);
+    }
+    m_max_id = std::max(m_max_id, id);
+    ++m_size;
+}
+
+std::int64_t node_index::position(std::int64_t const id) const
+{
+    auto const found = find(id);
+
+    if (found < 0)
+    {
+        throw std::domain_error("Node " + std::to_string(id) + " is not in the mesh");
+    }
+    return found;
+}
+
+bool node_index::contains(std::int64_t const id) const noexcept { return find(id) >= 0; }
+
+void node_index::build_table()
+{
+    m_contiguous = false;
+
+    reserve(std::max(m_size, m_reserved));
+
+    for (std::int64_t position = 0; position < m_size; ++position)
+    {
+        insert(m_first_id + position, position);
+    }
+}
+
+void node_index::insert(std::int64_t const id, std::int64_t const position)
+{
+    auto const mask = m_table.size() - 1;
+
+    for (auto i = bucket(id);; i = (i + 1) & mask)
+    {
+        if (m_table[i].first == empty_id || m_table[i].first == id)
+        {
+            m_table[i] = {id, position};
+            return;
+        }
+    }
+}
+
+std::int64_t node_index::find(std::int64_t const id) const noexcept
+{
+    if (m_contiguous)
+    {
+        return id >= m_first_id && id < m_first_id + m_size ? id - m_first_id : -1;
+    }
+
+    auto const mask = m_table.size() - 1;
+
+    for (auto i = bucket(id);; i = (i + 1) & mask)
+    {
+        if (m_table[i].first == id) return m_table[i].second;
+
+        if (m_table[i].first == empty_id) return -1;
+    }
+}
+
+std::size_t node_index::bucket(std::int64_t const id) const noexcept
+{
+    // Fibonacci hashing spreads the consecutive runs of ids over the table
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ull) >>
+                                    (64 - m_bits));
+}
+} // namespace imr
@@ -0,0 +1,76 @@
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace imr
+{
+/// node_index maps the gmsh node ids onto the position of each node in the
+/// node array.  While the ids are consecutive (the common case) the position
+/// is the offset from the first id and nothing is stored.  Once an id breaks
+/// the sequence, e.g. after Gmsh removed the duplicate nodes of a mesh or
+/// extracted part of a mesh, the ids are held in an open addressing hash
+/// table, so the storage depends on the number of nodes and not on the
+/// largest id.
+class node_index
+{
+public:
+    /// Remove every id while keeping the capacity of the table
+    void clear() noexcept;
+
+    /// Reserve the table for a number of nodes in case the ids are sparse
+    void reserve(std::int64_t const number_of_nodes);
+
+    /// Map the id onto the next position
+    void append(std::int64_t const id);
+
+    /// \return the position of the node with the id
+    /// \throw std::domain_error if the id was not appended
+    std::int64_t position(std::int64_t const id) const;
+
+    /// \return true if the id was appended
+    bool contains(std::int64_t const id) const noexcept;
+
+    /// \return true if the ids are consecutive in the order they were appended
+    bool contiguous() const noexcept { return m_contiguous; }
+
+    /// \return the number of ids
+    std::int64_t size() const noexcept { return m_size; }
+
+    /// \return the largest id, zero if there are no ids
+    std::int64_t max_id() const noexcept { return m_max_id; }
+
+    /// \return the bytes held by the hash table
+    std::size_t memory_bytes() const noexcept
+    {
+        return m_table.capacity() * sizeof(m_table.front());
+    }
+
+private:
+    /// Move the consecutive ids into the table
+    void build_table();
+
+    void insert(std::int64_t const id, std::int64_t const position);
+
+    /// \return the position of the id or -1 if the id is not present
+    std::int64_t find(std::int64_t const id) const noexcept;
+
+    std::size_t bucket(std::int64_t const id) const noexcept;
+
+private:
+    std::int64_t m_first_id = 1;
+    std::int64_t m_size     = 0;
+    std::int64_t m_max_id   = 0;
+    /// Number of nodes the table is sized for once it is built
+    std::int64_t m_reserved = 0;
+
+    bool m_contiguous = true;
+
+    /// Pairs of (id, position) with a power of two number of buckets
+    std::vector<std::pair<std::int64_t, std::int64_t>> m_table;
+    /// Number of bits of the bucket numbers
+    int m_bits = 0;
+};
+} // namespace imr
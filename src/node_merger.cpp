@@ -0,0 +1,146 @@
+
+#include "node_merger.hpp"
+
+#include "parallel_for.hpp"
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace imr
+{
+namespace
+{
+using cell_t = std::array<std::int64_t, 3>;
+
+/// Open addressing hash table mapping a grid cell onto the first node (in
+/// order of appearance) inside the cell.  The remaining nodes in the cell are
+/// linked through the next array in increasing order.  The cell of an entry is
+/// recomputed from the coordinates of its first node rather than stored.
+class spatial_hash
+{
+public:
+    spatial_hash(std::vector<node> const& nodes, double const cell_size)
+        : nodes(nodes), inverse_cell_size(1.0 / cell_size), next(nodes.size(), -1)
+    {
+        std::size_t capacity = 1;
+        while (capacity < 2 * nodes.size()) capacity <<= 1;
+
+        mask = capacity - 1;
+        heads.resize(capacity, -1);
+
+        // Insert in reverse so each cell lists its nodes in increasing order
+        for (auto i = static_cast<std::int64_t>(nodes.size()) - 1; i >= 0; --i)
+        {
+            auto& head = heads[find(cell(i))];
+            next[i]    = head;
+            head       = i;
+        }
+    }
+
+    cell_t cell(std::int64_t const i) const noexcept
+    {
+        auto const& x = nodes[i].coordinates;
+        return {static_cast<std::int64_t>(std::floor(x[0] * inverse_cell_size)),
+                static_cast<std::int64_t>(std::floor(x[1] * inverse_cell_size)),
+                static_cast<std::int64_t>(std::floor(x[2] * inverse_cell_size))};
+    }
+
+    /// \return first node in the cell or -1 if the cell is empty
+    std::int64_t first(cell_t const& c) const noexcept { return heads[find(c)]; }
+
+    std::int64_t following(std::int64_t const i) const noexcept { return next[i]; }
+
+private:
+    std::size_t find(cell_t const& c) const noexcept
+    {
+        auto slot = hash(c) & mask;
+        while (heads[slot] != -1 && cell(heads[slot]) != c)
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    static std::size_t hash(cell_t const& c) noexcept
+    {
+        auto const h = static_cast<std::uint64_t>(c[0]) * 73856093ull ^
+                       static_cast<std::uint64_t>(c[1]) * 19349663ull ^
+                       static_cast<std::uint64_t>(c[2]) * 83492791ull;
+        // Mix the high bits into the low bits used by the mask
+        return static_cast<std::size_t>(h ^ (h >> 29) ^ (h >> 43));
+    }
+
+private:
+    std::vector<node> const& nodes;
+    double inverse_cell_size;
+    std::size_t mask;
+    std::vector<std::int64_t> heads;
+    std::vector<std::int64_t> next;
+};
+
+double distance_squared(node const& a, node const& b) noexcept
+{
+    auto const dx = a.coordinates[0] - b.coordinates[0];
+    auto const dy = a.coordinates[1] - b.coordinates[1];
+    auto const dz = a.coordinates[2] - b.coordinates[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+}
+
+std::vector<std::int64_t> find_coincident_nodes(std::vector<node> const& nodes,
+                                                double const tolerance)
+{
+    if (!(tolerance > 0.0))
+    {
+        throw std::domain_error("The merge tolerance " + std::to_string(tolerance) +
+                                " must be positive");
+    }
+
+    spatial_hash const grid(nodes, tolerance);
+
+    auto const tolerance_squared = tolerance * tolerance;
+
+    std::vector<std::int64_t> representative(nodes.size());
+
+    // Find the first node within the tolerance in the surrounding cells
+    parallel_for(nodes.size(), [&](std::int64_t const first, std::int64_t const last) {
+        for (auto i = first; i < last; ++i)
+        {
+            auto const c = grid.cell(i);
+
+            auto match = i;
+
+            for (auto dx = -1; dx <= 1; ++dx)
+            {
+                for (auto dy = -1; dy <= 1; ++dy)
+                {
+                    for (auto dz = -1; dz <= 1; ++dz)
+                    {
+                        for (auto j = grid.first({c[0] + dx, c[1] + dy, c[2] + dz});
+                             j != -1 && j < match;
+                             j = grid.following(j))
+                        {
+                            if (distance_squared(nodes[i], nodes[j]) <= tolerance_squared)
+                            {
+                                match = j;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            representative[i] = match;
+        }
+    });
+
+    // Each node maps onto an earlier node, so resolving the chains in order
+    // merges clusters of nodes into their first node
+    for (std::size_t i = 0; i < representative.size(); ++i)
+    {
+        representative[i] = representative[representative[i]];
+    }
+    return representative;
+}
+} // namespace imr
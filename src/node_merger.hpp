@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "node.hpp"
+
+namespace imr
+{
+/// Find the nodes that coincide within a tolerance using a uniform grid with
+/// a cell size equal to the tolerance.  Each node is hashed into its cell and
+/// only the neighbouring cells are searched, so the work scales linearly with
+/// the number of nodes.  The search over the nodes is performed in parallel.
+/// \param nodes Nodal coordinates
+/// \param tolerance Maximum distance between two coincident nodes
+/// \return For each node position, the position of the node it is merged into.
+///         Coincident nodes are merged into the node that appears first, and
+///         a node that is not merged maps onto itself.
+std::vector<std::int64_t> find_coincident_nodes(std::vector<node> const& nodes,
+                                                double const tolerance);
+} // namespace imr
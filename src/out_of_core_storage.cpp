@@ -0,0 +1,237 @@
+
+#include "out_of_core_storage.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace imr
+{
+namespace
+{
+/// Element record header: id, type, physical id, geometric id, number of
+/// partition tags and number of nodes.  The header is followed by the
+/// partition tags and the node indices.
+constexpr std::size_t header_size = 6;
+
+template <typename T>
+void append_bytes(std::vector<char>& buffer, T const* data, std::size_t const size)
+{
+    auto const bytes = reinterpret_cast<char const*>(data);
+    buffer.insert(end(buffer), bytes, bytes + size * sizeof(T));
+}
+
+std::runtime_error system_error(std::string const& message)
+{
+    return std::runtime_error(message + ": " + std::strerror(errno));
+}
+}
+
+out_of_core_storage::out_of_core_storage(std::string const& output_stem,
+                                         std::size_t const memory_budget)
+    : m_memory_budget(memory_budget)
+{
+    std::vector<char> directory(begin(output_stem), end(output_stem));
+
+    for (auto const c : std::string(".imr-XXXXXX")) directory.push_back(c);
+    directory.push_back('\0');
+
+    if (::mkdtemp(directory.data()) == nullptr)
+    {
+        throw system_error("Temporary directory for " + output_stem + " could not be created");
+    }
+    m_directory = directory.data();
+
+    auto const node_file_name = m_directory + "/nodes";
+
+    m_node_file = ::open(node_file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if (m_node_file == -1)
+    {
+        // The destructor is not run, so the directory is removed here after
+        // the error is described
+        auto const error = system_error("Coordinate file " + node_file_name +
+                                        " could not be created");
+        ::rmdir(m_directory.c_str());
+        throw error;
+    }
+}
+
+out_of_core_storage::~out_of_core_storage()
+{
+    if (m_nodes != nullptr) ::munmap(const_cast<node*>(m_nodes), m_mapped_bytes);
+
+    if (m_node_file != -1) ::close(m_node_file);
+
+    std::remove((m_directory + "/nodes").c_str());
+
+    for (auto const& partition : m_partition_bytes)
+    {
+        std::remove(run_file_name(partition.first).c_str());
+    }
+    ::rmdir(m_directory.c_str());
+}
+
+void out_of_core_storage::append(node const& node_data)
+{
+    m_node_buffer.push_back(node_data);
+
+    if (m_node_buffer.size() * sizeof(node) > m_memory_budget / 8) flush_nodes();
+}
+
+void out_of_core_storage::append(element const& element_data, std::int32_t const partition)
+{
+    auto const& partition_tags = element_data.partitionTags();
+    auto const& node_indices   = element_data.node_indices();
+
+    std::int32_t const header[header_size] = {element_data.id(),
+                                              element_data.typeId(),
+                                              element_data.physicalId(),
+                                              element_data.geometricId(),
+                                              static_cast<std::int32_t>(partition_tags.size()),
+                                              static_cast<std::int32_t>(node_indices.size())};
+
+    auto& buffer = m_element_buffers[partition];
+
+    auto const size = buffer.size();
+
+    append_bytes(buffer, header, header_size);
+    append_bytes(buffer, partition_tags.data(), partition_tags.size());
+    append_bytes(buffer, node_indices.data(), node_indices.size());
+
+    m_buffered_bytes += buffer.size() - size;
+
+    // Spill every partition once the buffers exceed half of the budget
+    if (m_buffered_bytes > m_memory_budget / 2)
+    {
+        for (auto const& buffer : m_element_buffers) flush(buffer.first);
+    }
+}
+
+void out_of_core_storage::finalise()
+{
+    flush_nodes();
+
+    for (auto const& buffer : m_element_buffers) flush(buffer.first);
+
+    m_element_buffers.clear();
+
+    m_mapped_bytes = m_number_of_nodes * sizeof(node);
+
+    if (m_mapped_bytes == 0) return;
+
+    auto const address = ::mmap(nullptr, m_mapped_bytes, PROT_READ, MAP_SHARED, m_node_file, 0);
+
+    if (address == MAP_FAILED)
+    {
+        throw system_error("Coordinate file could not be mapped into memory");
+    }
+    m_nodes = static_cast<node const*>(address);
+}
+
+std::size_t out_of_core_storage::partition_bytes(std::int32_t const partition) const
+{
+    auto const found = m_partition_bytes.find(partition);
+    return found == end(m_partition_bytes) ? 0 : found->second;
+}
+
+void out_of_core_storage::for_each_element(std::int32_t const partition,
+                                           std::function<void(element&&)> const& function) const
+{
+    if (partition_bytes(partition) == 0) return;
+
+    std::ifstream run_file(run_file_name(partition), std::ios::binary);
+
+    if (!run_file.is_open())
+    {
+        throw std::runtime_error("Run file for partition " + std::to_string(partition) +
+                                 " could not be opened");
+    }
+
+    std::int32_t header[header_size];
+
+    while (run_file.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        // Physical and geometric ids followed by the partition tags
+        std::vector<std::int32_t> tags(2 + header[4]);
+        std::vector<std::int64_t> node_indices(header[5]);
+
+        tags[element::Physical]  = header[2];
+        tags[element::Geometric] = header[3];
+
+        run_file.read(reinterpret_cast<char*>(tags.data() + 2), header[4] * sizeof(std::int32_t));
+        run_file.read(reinterpret_cast<char*>(node_indices.data()),
+                      node_indices.size() * sizeof(std::int64_t));
+
+        function(element(std::move(node_indices), std::move(tags), header[1], header[0]));
+    }
+}
+
+void out_of_core_storage::release_nodes() const
+{
+    if (m_nodes != nullptr)
+    {
+        ::madvise(const_cast<node*>(m_nodes), m_mapped_bytes, MADV_DONTNEED);
+    }
+}
+
+void out_of_core_storage::flush(std::int32_t const partition)
+{
+    auto& buffer = m_element_buffers[partition];
+
+    if (buffer.empty()) return;
+
+    auto const file_name = run_file_name(partition);
+
+    auto run_file = std::fopen(file_name.c_str(), "ab");
+
+    if (run_file == nullptr)
+    {
+        throw system_error("Run file " + file_name + " could not be opened");
+    }
+
+    auto const written = std::fwrite(buffer.data(), 1, buffer.size(), run_file);
+
+    std::fclose(run_file);
+
+    if (written != buffer.size())
+    {
+        throw system_error("Run file " + file_name + " could not be written");
+    }
+
+    m_partition_bytes[partition] += buffer.size();
+    m_buffered_bytes -= buffer.size();
+
+    // Release the memory rather than only clearing the buffer
+    std::vector<char>().swap(buffer);
+}
+
+void out_of_core_storage::flush_nodes()
+{
+    if (m_node_buffer.empty()) return;
+
+    auto const bytes  = m_node_buffer.size() * sizeof(node);
+    auto const offset = static_cast<off_t>(m_number_of_nodes * sizeof(node));
+
+    if (::pwrite(m_node_file, m_node_buffer.data(), bytes, offset) !=
+        static_cast<ssize_t>(bytes))
+    {
+        throw system_error("Coordinate file could not be written");
+    }
+
+    m_number_of_nodes += m_node_buffer.size();
+    m_node_buffer.clear();
+}
+
+std::string out_of_core_storage::run_file_name(std::int32_t const partition) const
+{
+    return m_directory + "/partition" + std::to_string(partition);
+}
+} // namespace imr
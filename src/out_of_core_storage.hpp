@@ -0,0 +1,86 @@
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "element.hpp"
+#include "node.hpp"
+
+namespace imr
+{
+/// out_of_core_storage holds the nodes and elements of a mesh which is too
+/// large to fit in memory in temporary files.  The nodes are written to a
+/// coordinate file in the order they are appended, which is memory mapped
+/// once the mesh has been read, and the elements are spilled into a run file for the
+/// partition that owns them.  The elements are buffered in memory until the
+/// buffers exceed half of the memory budget.
+/// The temporary files are placed in a directory next to the output files and
+/// are removed when the storage is destroyed.
+class out_of_core_storage
+{
+public:
+    /// \param output_stem Output file name without the extension
+    /// \param memory_budget Maximum number of bytes to hold in memory
+    explicit out_of_core_storage(std::string const& output_stem, std::size_t const memory_budget);
+
+    ~out_of_core_storage();
+
+    out_of_core_storage(out_of_core_storage const&) = delete;
+    out_of_core_storage& operator=(out_of_core_storage const&) = delete;
+
+    /// Append a node to the end of the coordinate file
+    void append(node const& node_data);
+
+    /// Append an element to the run file of a partition
+    void append(element const& element_data, std::int32_t const partition);
+
+    /// Flush the remaining buffers and map the coordinate file into memory
+    void finalise();
+
+    /// Return the nodes in the order they were appended \sa finalise
+    node const* nodes() const noexcept { return m_nodes; }
+
+    /// Return the number of nodes in the coordinate file
+    std::int64_t number_of_nodes() const noexcept { return m_number_of_nodes; }
+
+    /// Return the number of bytes spilled to the run file of a partition
+    std::size_t partition_bytes(std::int32_t const partition) const;
+
+    /// Read back the elements of a partition in the order they were appended
+    void for_each_element(std::int32_t const partition,
+                          std::function<void(element&&)> const& function) const;
+
+    /// Release the pages of the coordinate file held in memory
+    void release_nodes() const;
+
+    std::size_t memory_budget() const noexcept { return m_memory_budget; }
+
+private:
+    void flush(std::int32_t const partition);
+
+    void flush_nodes();
+
+    std::string run_file_name(std::int32_t const partition) const;
+
+private:
+    std::string m_directory;
+    std::size_t m_memory_budget;
+
+    /// Buffered nodes for the coordinate file
+    std::vector<node> m_node_buffer;
+    std::int64_t m_number_of_nodes = 0;
+    int m_node_file = -1;
+
+    /// Buffered element records for each partition
+    std::map<std::int32_t, std::vector<char>> m_element_buffers;
+    std::map<std::int32_t, std::size_t> m_partition_bytes;
+    std::size_t m_buffered_bytes = 0;
+
+    node const* m_nodes = nullptr;
+    std::size_t m_mapped_bytes = 0;
+};
+} // namespace imr
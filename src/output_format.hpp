@@ -0,0 +1,38 @@
+
+#pragma once
+
+namespace imr
+{
+/// Compression of the written files
+enum class compression
+{
+    none,
+    gzip
+};
+
+/// output_format selects the precision of the data written for each mesh
+/// partition and of the data held while the partition is written
+struct output_format
+{
+    /// Width in bits of the node indices held while writing a partition (32 or
+    /// 64), or zero to use 32 bits whenever the node ids fit
+    int index_width = 0;
+
+    /// Round the coordinates to single precision and write digits which
+    /// recover the float
+    bool single_precision = false;
+
+    /// Significant digits of the written coordinates (1 to 17), or zero for
+    /// digits which read back as the same number (shortest in almost all cases)
+    int significant_digits = 0;
+
+    /// Write the document without whitespace and write the coordinates and
+    /// the nodal connectivities as flat arrays, with the number of values for
+    /// each node or element in a "Stride" member of the group
+    bool compact = false;
+
+    /// Compress each written file, whose name gets the suffix of the
+    /// compression method \sa block_compressor
+    compression compress = compression::none;
+};
+} // namespace imr
@@ -0,0 +1,123 @@
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace imr
+{
+/// Return the number of hardware threads available (at least one)
+inline unsigned hardware_threads() noexcept
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Return the maximum number of threads the parallel algorithms may use on
+/// the calling thread, where zero (the default) places no limit.  This allows
+/// a conversion running alongside others to be restricted to its share of the
+/// hardware threads.
+inline unsigned& thread_limit() noexcept
+{
+    thread_local unsigned limit = 0;
+    return limit;
+}
+
+/// Return the number of threads available to the calling thread
+inline unsigned available_threads() noexcept
+{
+    return thread_limit() == 0 ? hardware_threads() : std::min(thread_limit(), hardware_threads());
+}
+
+/// Split the range [0, size) into contiguous chunks and call
+/// function(first, last) for each chunk on a separate thread.
+/// Small ranges are processed on the calling thread.  The first exception
+/// thrown by a chunk (in chunk order) is rethrown on the calling thread once
+/// all of the chunks have finished.
+template <typename Function>
+void parallel_for(std::int64_t const size, Function&& function)
+{
+    constexpr std::int64_t minimum_chunk_size = 1 << 14;
+
+    auto const chunks = std::min<std::int64_t>(available_threads(),
+                                               (size + minimum_chunk_size - 1) /
+                                                   minimum_chunk_size);
+    if (chunks <= 1)
+    {
+        if (size > 0) function(std::int64_t{0}, size);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(chunks);
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks);
+
+    for (std::int64_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        threads.emplace_back([&, chunk]() {
+            try
+            {
+                function(size * chunk / chunks, size * (chunk + 1) / chunks);
+            }
+            catch (...)
+            {
+                errors[chunk] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (auto const& error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+/// Call task(i) for each i in [0, count) with the tasks distributed
+/// dynamically over the available threads, which inherit the thread limit of
+/// the calling thread.  The first exception thrown by a task (in task order)
+/// is rethrown on the calling thread once all of the tasks have finished.
+template <typename Task>
+void parallel_tasks(std::size_t const count, Task&& task)
+{
+    std::vector<std::exception_ptr> errors(count);
+
+    std::atomic<std::size_t> next{0};
+
+    auto const limit = thread_limit();
+
+    auto const worker = [&]() {
+        thread_limit() = limit;
+
+        for (auto i = next++; i < count; i = next++)
+        {
+            try
+            {
+                task(i);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < std::min<std::size_t>(available_threads(), count); ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : threads) thread.join();
+
+    for (auto const& error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+}
+} // namespace imr
@@ -0,0 +1,203 @@
+
+#include "partition_metrics.hpp"
+
+#include "json_writer.hpp"
+#include "mesh_reader.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include <json/json.h>
+
+namespace imr
+{
+namespace
+{
+/// Return the ratio of the maximum to the average of a partition quantity
+template <typename Accessor>
+double imbalance(std::vector<partition_statistics> const& partitions, Accessor&& accessor)
+{
+    if (partitions.empty()) return 1.0;
+
+    double maximum = 0.0, sum = 0.0;
+    for (auto const& partition : partitions)
+    {
+        auto const value = static_cast<double>(accessor(partition));
+        maximum          = std::max(maximum, value);
+        sum += value;
+    }
+    return sum > 0.0 ? maximum * partitions.size() / sum : 1.0;
+}
+
+void sort_unique(std::vector<std::int64_t>& values)
+{
+    std::sort(begin(values), end(values));
+    values.erase(std::unique(begin(values), end(values)), end(values));
+}
+}
+
+std::int64_t element_cost(std::int64_t const number_of_nodes) noexcept
+{
+    return number_of_nodes * number_of_nodes;
+}
+
+partition_metrics::partition_metrics(mesh_reader const& reader)
+    : m_partitions(reader.numberOfPartitions())
+{
+    if (reader.out_of_core())
+    {
+        throw std::domain_error("Partition metrics are not available for an out-of-core mesh");
+    }
+
+    auto const partitions = static_cast<std::int32_t>(m_partitions.size());
+
+    for (std::int32_t partition = 0; partition < partitions; ++partition)
+    {
+        m_partitions[partition].partition = partition;
+    }
+
+    // Nodes of the owned elements and the interface nodes for each partition
+    std::vector<std::vector<std::int64_t>> partition_nodes(partitions);
+    std::vector<std::vector<std::int64_t>> interface_nodes(partitions);
+
+    for (auto const& mesh : reader.mesh())
+    {
+        for (auto const& element : mesh.second)
+        {
+            auto const partition = element.owner_process() - 1;
+
+            if (partition < 0 || partition >= partitions) continue;
+
+            auto& statistics = m_partitions[partition];
+
+            auto const& connectivity = element.node_indices();
+
+            ++statistics.elements;
+            statistics.weighted_elements += element_cost(connectivity.size());
+
+            // Each of the remaining partition tags after the count and the
+            // owner is a partition the element is ghosted into
+            if (element.isSharedByMultipleProcesses())
+            {
+                statistics.edge_cut += element.partitionTags().size() - 2;
+            }
+
+            partition_nodes[partition].insert(end(partition_nodes[partition]),
+                                              begin(connectivity),
+                                              end(connectivity));
+        }
+    }
+
+    // The nodes on the interface of two partitions are the intersection of the
+    // nodes each partition contributes to the interface
+    for (auto const& interface : reader.interfaces())
+    {
+        auto const master_partition = interface.first.first;
+        auto const slave_partition  = interface.first.second;
+
+        if (master_partition < 1 || master_partition >= slave_partition ||
+            slave_partition > partitions)
+        {
+            continue;
+        }
+
+        auto const found = reader.interfaces().find({slave_partition, master_partition});
+
+        if (found == end(reader.interfaces())) continue;
+
+        std::vector<std::int64_t> intersection;
+
+        std::set_intersection(begin(interface.second),
+                              end(interface.second),
+                              begin(found->second),
+                              end(found->second),
+                              std::back_inserter(intersection));
+
+        if (intersection.empty()) continue;
+
+        for (auto const partition : {master_partition - 1, slave_partition - 1})
+        {
+            ++m_partitions[partition].neighbours;
+            interface_nodes[partition].insert(end(interface_nodes[partition]),
+                                              begin(intersection),
+                                              end(intersection));
+        }
+    }
+
+    for (std::int32_t partition = 0; partition < partitions; ++partition)
+    {
+        sort_unique(partition_nodes[partition]);
+        sort_unique(interface_nodes[partition]);
+
+        m_partitions[partition].nodes           = partition_nodes[partition].size();
+        m_partitions[partition].interface_nodes = interface_nodes[partition].size();
+    }
+}
+
+double partition_metrics::element_imbalance() const noexcept
+{
+    return imbalance(m_partitions, [](auto const& p) { return p.weighted_elements; });
+}
+
+double partition_metrics::node_imbalance() const noexcept
+{
+    return imbalance(m_partitions, [](auto const& p) { return p.nodes; });
+}
+
+double partition_metrics::interface_imbalance() const noexcept
+{
+    return imbalance(m_partitions, [](auto const& p) { return p.interface_nodes; });
+}
+
+void partition_metrics::print(std::ostream& out) const
+{
+    out << std::string(2, ' ') << std::setw(10) << "Partition" << std::setw(12) << "Elements"
+        << std::setw(12) << "Weighted" << std::setw(12) << "Nodes" << std::setw(12) << "Interface"
+        << std::setw(12) << "Neighbours" << std::setw(12) << "Edge cut"
+        << "\n";
+
+    for (auto const& p : m_partitions)
+    {
+        out << std::string(2, ' ') << std::setw(10) << p.partition << std::setw(12) << p.elements
+            << std::setw(12) << p.weighted_elements << std::setw(12) << p.nodes << std::setw(12)
+            << p.interface_nodes << std::setw(12) << p.neighbours << std::setw(12) << p.edge_cut
+            << "\n";
+    }
+
+    out << std::string(2, ' ') << "Imbalance (max / avg): elements " << element_imbalance()
+        << ", nodes " << node_imbalance() << ", interface nodes " << interface_imbalance()
+        << "\n";
+}
+
+void partition_metrics::write(std::string const& output_file_name) const
+{
+    Json::Value report;
+
+    for (auto const& p : m_partitions)
+    {
+        Json::Value partition;
+        partition["Partition"]        = p.partition;
+        partition["Elements"]         = static_cast<Json::Int64>(p.elements);
+        partition["WeightedElements"] = static_cast<Json::Int64>(p.weighted_elements);
+        partition["Nodes"]            = static_cast<Json::Int64>(p.nodes);
+        partition["InterfaceNodes"]   = static_cast<Json::Int64>(p.interface_nodes);
+        partition["Neighbours"]       = p.neighbours;
+        partition["EdgeCut"]          = static_cast<Json::Int64>(p.edge_cut);
+
+        report["Partitions"].append(partition);
+    }
+
+    report["Imbalance"]["Elements"]       = element_imbalance();
+    report["Imbalance"]["Nodes"]          = node_imbalance();
+    report["Imbalance"]["InterfaceNodes"] = interface_imbalance();
+
+    std::fstream writer;
+    writer.open(output_file_name, std::ios::out);
+
+    writer << json_writer().write(report);
+    writer.close();
+}
+} // namespace imr
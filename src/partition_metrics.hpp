@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace imr
+{
+class mesh_reader;
+
+/// Load balance and communication statistics for a single mesh partition
+struct partition_statistics
+{
+    /// Zero based partition number (matches the output file suffix)
+    std::int32_t partition = 0;
+    /// Number of elements owned by the partition
+    std::int64_t elements = 0;
+    /// Sum of the element costs \sa element_cost
+    std::int64_t weighted_elements = 0;
+    /// Number of unique nodes referenced by the owned elements
+    std::int64_t nodes = 0;
+    /// Number of nodes shared with at least one other partition
+    std::int64_t interface_nodes = 0;
+    /// Number of partitions sharing at least one node with this partition
+    std::int32_t neighbours = 0;
+    /// Number of (owned element, ghost partition) pairs
+    std::int64_t edge_cut = 0;
+};
+
+/// Return the relative cost of an element with the given number of nodes.
+/// The cost is taken as the size of the element matrix (nodes squared) since
+/// this dominates the assembly work performed by the solver
+std::int64_t element_cost(std::int64_t const number_of_nodes) noexcept;
+
+/// partition_metrics computes the load balance and communication volume of
+/// each partition from the element groups and the interface map built while
+/// reading the mesh, avoiding any further parsing of the input file
+class partition_metrics
+{
+public:
+    /// \throw std::domain_error if the elements of the reader are out of core
+    explicit partition_metrics(mesh_reader const& reader);
+
+    /// Return the statistics of each partition ordered by partition number
+    std::vector<partition_statistics> const& partitions() const noexcept { return m_partitions; }
+
+    /// Return the ratio of the maximum to the average weighted element count
+    double element_imbalance() const noexcept;
+
+    /// Return the ratio of the maximum to the average node count
+    double node_imbalance() const noexcept;
+
+    /// Return the ratio of the maximum to the average interface node count
+    double interface_imbalance() const noexcept;
+
+    /// Print a per partition table and the imbalance summary
+    void print(std::ostream& out) const;
+
+    /// Write the statistics as a machine readable JSON report
+    /// \param output_file_name Name of the report file
+    void write(std::string const& output_file_name) const;
+
+private:
+    std::vector<partition_statistics> m_partitions;
+};
+} // namespace imr
@@ -0,0 +1,307 @@
+
+#include "phase_timer.hpp"
+
+#include "json_writer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <tuple>
+
+#include <json/json.h>
+
+#include <unistd.h>
+
+namespace imr
+{
+namespace detail
+{
+std::atomic<bool> timers_enabled{false};
+std::atomic<bool> tracing_enabled{false};
+}
+
+namespace
+{
+/// Phase being timed on a thread
+struct active_phase
+{
+    std::string phase;
+    char const* name;
+    std::int32_t partition;
+};
+
+using timing_key = std::tuple<std::string, std::int32_t, std::int32_t>;
+
+/// Complete event of a phase for the trace
+struct trace_event
+{
+    char const* name;
+    std::int32_t partition;
+    std::int32_t thread;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration duration;
+};
+
+struct timing_registry
+{
+    std::mutex mutex;
+    /// Order in which each phase first started
+    std::map<std::string, std::size_t> order;
+    std::map<timing_key, phase_timing> timings;
+    std::vector<trace_event> events;
+};
+
+timing_registry& registry()
+{
+    static timing_registry instance;
+    return instance;
+}
+
+std::vector<active_phase>& active_phases()
+{
+    thread_local std::vector<active_phase> phases;
+    return phases;
+}
+
+std::int32_t thread_number()
+{
+    static std::atomic<std::int32_t> threads{0};
+    thread_local std::int32_t const number = threads++;
+    return number;
+}
+}
+
+void enable_timers(bool const enable) noexcept
+{
+    detail::timers_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void reset_timers()
+{
+    auto& timers = registry();
+
+    std::lock_guard<std::mutex> lock(timers.mutex);
+    timers.order.clear();
+    timers.timings.clear();
+    timers.events.clear();
+}
+
+void enable_tracing(bool const enable) noexcept
+{
+    detail::tracing_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void write_trace(std::string const& output_file_name)
+{
+    auto& timers = registry();
+
+    std::lock_guard<std::mutex> lock(timers.mutex);
+
+    Json::Value trace(Json::objectValue);
+    trace["traceEvents"] = Json::Value(Json::arrayValue);
+    trace["displayTimeUnit"] = "ms";
+
+    auto const process = static_cast<Json::Int64>(::getpid());
+
+    // The timestamps are given in microseconds from the first event
+    auto const origin = timers.events.empty()
+                            ? std::chrono::steady_clock::time_point{}
+                            : std::min_element(begin(timers.events),
+                                               end(timers.events),
+                                               [](auto const& left, auto const& right) {
+                                                   return left.start < right.start;
+                                               })
+                                  ->start;
+
+    using microseconds = std::chrono::duration<double, std::micro>;
+
+    for (auto const& event : timers.events)
+    {
+        Json::Value trace_event;
+        trace_event["name"] = event.name;
+        trace_event["cat"]  = "imr";
+        trace_event["ph"]   = "X";
+        trace_event["ts"]   = microseconds(event.start - origin).count();
+        trace_event["dur"]  = microseconds(event.duration).count();
+        trace_event["pid"]  = process;
+        trace_event["tid"]  = event.thread;
+
+        if (event.partition >= 0) trace_event["args"]["partition"] = event.partition;
+
+        trace["traceEvents"].append(trace_event);
+    }
+
+    std::fstream writer;
+    writer.open(output_file_name, std::ios::out);
+
+    writer << json_writer().write(trace);
+    writer.close();
+}
+
+std::vector<phase_timing> recorded_timings()
+{
+    auto& timers = registry();
+
+    std::lock_guard<std::mutex> lock(timers.mutex);
+
+    std::vector<phase_timing> timings;
+    for (auto const& timing : timers.timings) timings.push_back(timing.second);
+
+    std::stable_sort(begin(timings), end(timings), [&](auto const& left, auto const& right) {
+        return timers.order.at(left.phase) < timers.order.at(right.phase);
+    });
+    return timings;
+}
+
+void print_timings(std::ostream& out)
+{
+    auto const timings = recorded_timings();
+
+    out << std::string(2, ' ') << std::left << std::setw(40) << "Phase" << std::right
+        << std::setw(10) << "Calls" << std::setw(14) << "Seconds" << std::setw(12)
+        << "Partitions" << std::setw(10) << "Threads" << std::setw(16) << "Peak RSS [MiB]"
+        << "\n";
+
+    for (auto first = begin(timings); first != end(timings);)
+    {
+        auto const last = std::find_if(first, end(timings), [&](auto const& timing) {
+            return timing.phase != first->phase;
+        });
+
+        std::int64_t calls = 0, peak_resident_bytes = 0;
+        double seconds     = 0.0;
+        std::set<std::int32_t> partitions, threads;
+
+        for (auto timing = first; timing != last; ++timing)
+        {
+            calls += timing->calls;
+            seconds += timing->seconds;
+            if (timing->partition >= 0) partitions.insert(timing->partition);
+            threads.insert(timing->thread);
+
+            peak_resident_bytes = std::max(peak_resident_bytes, timing->peak_resident_bytes);
+        }
+
+        // Indent the nested phases and only show the name of the phase
+        auto const depth = std::count(begin(first->phase), end(first->phase), '/');
+        auto const name  = first->phase.substr(first->phase.find_last_of('/') + 1);
+
+        out << std::string(2 + 2 * depth, ' ') << std::left << std::setw(40 - 2 * depth) << name
+            << std::right << std::setw(10) << calls << std::setw(14) << std::fixed
+            << std::setprecision(6) << seconds << std::setw(12) << partitions.size()
+            << std::setw(10) << threads.size() << std::setw(16);
+
+        if (peak_resident_bytes > 0)
+        {
+            out << std::setprecision(1) << peak_resident_bytes / 1048576.0;
+        }
+        else
+        {
+            out << "-";
+        }
+        out << std::defaultfloat << "\n";
+
+        first = last;
+    }
+}
+
+void write_timings(std::string const& output_file_name)
+{
+    Json::Value report(Json::objectValue);
+
+    for (auto const& timing : recorded_timings())
+    {
+        Json::Value phase;
+        phase["Phase"]     = timing.phase;
+        phase["Partition"] = timing.partition;
+        phase["Thread"]    = timing.thread;
+        phase["Calls"]     = static_cast<Json::Int64>(timing.calls);
+        phase["Seconds"]   = timing.seconds;
+
+        if (timing.peak_resident_bytes > 0)
+        {
+            phase["PeakResidentBytes"] = static_cast<Json::Int64>(timing.peak_resident_bytes);
+        }
+
+        report["Phases"].append(phase);
+    }
+
+    std::fstream writer;
+    writer.open(output_file_name, std::ios::out);
+
+    writer << json_writer().write(report);
+    writer.close();
+}
+
+void scoped_timer::start(char const* name, std::int32_t const partition)
+{
+    auto& phases = active_phases();
+
+    auto path = phases.empty() ? std::string(name) : phases.back().phase + "/" + name;
+
+    auto const inherited = phases.empty() ? -1 : phases.back().partition;
+
+    {
+        auto& timers = registry();
+
+        std::lock_guard<std::mutex> lock(timers.mutex);
+        timers.order.emplace(path, timers.order.size());
+    }
+
+    phases.push_back({std::move(path), name, partition >= 0 ? partition : inherited});
+
+    m_start_memory = memory_accounting_enabled() ? read_resident_memory() : resident_memory{};
+
+    m_start = std::chrono::steady_clock::now();
+}
+
+void scoped_timer::stop()
+{
+    auto const elapsed = std::chrono::steady_clock::now() - m_start;
+
+    // The high water mark only rises if the peak of the phase exceeds the
+    // previous peak, otherwise the peak is taken from the start and the end
+    std::int64_t peak_resident_bytes = 0;
+
+    if (m_start_memory.peak > 0)
+    {
+        auto const end_memory = read_resident_memory();
+
+        peak_resident_bytes = end_memory.peak > m_start_memory.peak
+                                  ? end_memory.peak
+                                  : std::max(m_start_memory.current, end_memory.current);
+    }
+
+    auto& phases = active_phases();
+
+    auto& timers = registry();
+    {
+        std::lock_guard<std::mutex> lock(timers.mutex);
+
+        auto const& phase = phases.back();
+
+        // The phase may have been started before the timings were reset
+        timers.order.emplace(phase.phase, timers.order.size());
+
+        auto& timing = timers.timings[timing_key{phase.phase, phase.partition, thread_number()}];
+
+        timing.phase     = phase.phase;
+        timing.partition = phase.partition;
+        timing.thread    = thread_number();
+        timing.calls += 1;
+        timing.seconds += std::chrono::duration<double>(elapsed).count();
+        timing.peak_resident_bytes = std::max(timing.peak_resident_bytes, peak_resident_bytes);
+
+        if (detail::tracing_enabled.load(std::memory_order_relaxed))
+        {
+            timers.events.push_back(
+                {phase.name, phase.partition, thread_number(), m_start, elapsed});
+        }
+    }
+    phases.pop_back();
+}
+} // namespace imr
@@ -0,0 +1,107 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "memory_usage.hpp"
+
+namespace imr
+{
+/// Accumulated time spent in a phase by one thread for one partition
+struct phase_timing
+{
+    /// Names of the enclosing phases and the phase separated by '/'
+    std::string phase;
+    /// Zero based partition or -1 if the phase does not work on a partition
+    std::int32_t partition = -1;
+    /// Thread number in the order the threads first timed a phase
+    std::int32_t thread = 0;
+    std::int64_t calls = 0;
+    double seconds = 0.0;
+    /// Largest resident set size during the phase if memory is accounted
+    std::int64_t peak_resident_bytes = 0;
+};
+
+namespace detail
+{
+extern std::atomic<bool> timers_enabled;
+extern std::atomic<bool> tracing_enabled;
+}
+
+/// Return true if the scoped timers record their phases
+inline bool timers_enabled() noexcept
+{
+    return detail::timers_enabled.load(std::memory_order_relaxed);
+}
+
+/// Enable or disable the scoped timers.  The timers are disabled by default
+/// and then only check this flag.
+void enable_timers(bool const enable = true) noexcept;
+
+/// Discard the recorded timings
+void reset_timers();
+
+/// Return the recorded timings ordered by the time each phase first started,
+/// then by partition and thread
+std::vector<phase_timing> recorded_timings();
+
+/// Print the recorded timings of each phase summed over the partitions and
+/// the threads, indenting the nested phases, with the peak resident set size
+/// when the memory is accounted
+void print_timings(std::ostream& out);
+
+/// Write the recorded timings for each phase, partition and thread to a
+/// JSON report for tracking performance regressions
+void write_timings(std::string const& output_file_name);
+
+/// Enable or disable recording an event for each timed phase (the timers
+/// also need to be enabled) for a timeline of the conversion
+void enable_tracing(bool const enable = true) noexcept;
+
+/// Write the recorded events in the Chrome trace event format, which can be
+/// loaded into a timeline viewer such as chrome://tracing or Perfetto.  Each
+/// phase is a complete event on the thread which timed it, with the
+/// partition as an argument.
+void write_trace(std::string const& output_file_name);
+
+/// scoped_timer records the time from its construction to its destruction
+/// for a phase.  A timer constructed while another is alive on the same
+/// thread records a nested phase, and the timings are aggregated by phase,
+/// partition and thread.  The peak resident set size of each phase is
+/// sampled from the process when memory accounting is enabled.
+class scoped_timer
+{
+public:
+    /// \param name Name of the phase, which must outlive the timer
+    /// \param partition Zero based partition the phase works on, by default
+    ///        the partition of the enclosing phase
+    explicit scoped_timer(char const* name, std::int32_t const partition = -1)
+        : m_active(timers_enabled())
+    {
+        if (m_active) start(name, partition);
+    }
+
+    ~scoped_timer()
+    {
+        if (m_active) stop();
+    }
+
+    scoped_timer(scoped_timer const&) = delete;
+    scoped_timer& operator=(scoped_timer const&) = delete;
+
+private:
+    void start(char const* name, std::int32_t const partition);
+
+    void stop();
+
+private:
+    bool m_active;
+    std::chrono::steady_clock::time_point m_start;
+    resident_memory m_start_memory;
+};
+} // namespace imr
@@ -0,0 +1,413 @@
+#include "real_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace imr
+{
+namespace
+{
+/// Floating point number f * 2^e with a 64 bit significand
+struct diy_fp
+{
+    std::uint64_t f;
+    int e;
+};
+
+diy_fp subtract(diy_fp const x, diy_fp const y) noexcept { return {x.f - y.f, x.e}; }
+
+/// \return the upper half of the 128 bit product, rounded to nearest
+diy_fp multiply(diy_fp const x, diy_fp const y) noexcept
+{
+    std::uint64_t const low_mask = 0xFFFFFFFFu;
+
+    std::uint64_t const x_low = x.f & low_mask, x_high = x.f >> 32;
+    std::uint64_t const y_low = y.f & low_mask, y_high = y.f >> 32;
+
+    std::uint64_t const low_low   = x_low * y_low;
+    std::uint64_t const low_high  = x_low * y_high;
+    std::uint64_t const high_low  = x_high * y_low;
+    std::uint64_t const high_high = x_high * y_high;
+
+    std::uint64_t middle = (low_low >> 32) + (low_high & low_mask) + (high_low & low_mask);
+    middle += std::uint64_t{1} << 31;
+
+    return {high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32), x.e + y.e + 64};
+}
+
+diy_fp normalize(diy_fp x) noexcept
+{
+    while ((x.f >> 63) == 0)
+    {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+/// A number and the boundaries halfway to its neighbours, which share the
+/// exponent of the upper boundary
+struct boundaries
+{
+    diy_fp w;
+    diy_fp minus;
+    diy_fp plus;
+};
+
+/// \return the boundaries of a positive number stored in Bits
+template <typename Real, typename Bits>
+boundaries compute_boundaries(Real const value) noexcept
+{
+    constexpr int precision     = std::numeric_limits<Real>::digits;
+    constexpr int bias          = std::numeric_limits<Real>::max_exponent - 1 + precision - 1;
+    constexpr int min_exponent  = 1 - bias;
+    constexpr Bits hidden_bit   = Bits{1} << (precision - 1);
+
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    Bits const biased_exponent = bits >> (precision - 1);
+    Bits const fraction        = bits & (hidden_bit - 1);
+
+    diy_fp const v = biased_exponent == 0
+                         ? diy_fp{fraction, min_exponent}
+                         : diy_fp{fraction + hidden_bit, static_cast<int>(biased_exponent) - bias};
+
+    // The lower neighbour is closer for powers of two, except for the
+    // smallest normal number whose lower neighbour is a subnormal number
+    bool const lower_boundary_is_closer = fraction == 0 && biased_exponent > 1;
+
+    diy_fp const plus{2 * v.f + 1, v.e - 1};
+    diy_fp const minus = lower_boundary_is_closer ? diy_fp{4 * v.f - 1, v.e - 2}
+                                                  : diy_fp{2 * v.f - 1, v.e - 1};
+
+    auto const normalized_plus = normalize(plus);
+
+    return {normalize(v),
+            {minus.f << (minus.e - normalized_plus.e), normalized_plus.e},
+            normalized_plus};
+}
+
+/// Normalized power of ten 10^k = f * 2^e, rounded to nearest
+struct cached_power
+{
+    std::uint64_t f;
+    int e;
+    int k;
+};
+
+// Every eighth power of ten from 10^-300 to 10^324, generated with exact
+// rational arithmetic
+constexpr cached_power cached_powers[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+/// Range of the binary exponent of the scaled numbers, so the integral part
+/// of the scaled upper boundary fits in 32 bits
+constexpr int alpha = -60;
+constexpr int gamma = -32;
+
+/// \return the power of ten c such that alpha <= c.e + e + 64 <= gamma
+cached_power const& cached_power_for(int const e) noexcept
+{
+    // k = ceil((alpha - e - 1) * log10(2)) in fixed point arithmetic
+    int const f = alpha - e - 1;
+    int const k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+
+    return cached_powers[(300 + k + 7) / 8];
+}
+
+/// \return the number of decimal digits of n and the largest power of ten
+/// which is not larger than n
+int largest_power_of_ten(std::uint32_t const n, std::uint32_t& power_of_ten) noexcept
+{
+    int digits = 10;
+
+    for (power_of_ten = 1000000000; power_of_ten > n && digits > 1; power_of_ten /= 10)
+    {
+        --digits;
+    }
+    return digits;
+}
+
+/// Move the last digit towards the number while the digits stay within the
+/// boundaries
+void round_last_digit(char* const digits,
+                      int const length,
+                      std::uint64_t const distance,
+                      std::uint64_t const delta,
+                      std::uint64_t rest,
+                      std::uint64_t const ten_k) noexcept
+{
+    while (rest < distance && delta - rest >= ten_k &&
+           (rest + ten_k < distance || distance - rest > rest + ten_k - distance))
+    {
+        --digits[length - 1];
+        rest += ten_k;
+    }
+}
+
+/// Generate the shortest digits in the scaled boundaries [minus, plus]
+/// closest to the scaled number w
+void generate_digits(char* const digits,
+                     int& length,
+                     int& decimal_exponent,
+                     diy_fp const minus,
+                     diy_fp const w,
+                     diy_fp const plus) noexcept
+{
+    std::uint64_t delta    = subtract(plus, minus).f;
+    std::uint64_t distance = subtract(plus, w).f;
+
+    // Split the upper boundary into an integral and a fractional part
+    diy_fp const one{std::uint64_t{1} << -plus.e, plus.e};
+
+    auto integral   = static_cast<std::uint32_t>(plus.f >> -one.e);
+    auto fractional = plus.f & (one.f - 1);
+
+    std::uint32_t power_of_ten;
+
+    for (auto n = largest_power_of_ten(integral, power_of_ten); n > 0; power_of_ten /= 10)
+    {
+        auto const digit = integral / power_of_ten;
+        integral %= power_of_ten;
+
+        digits[length++] = static_cast<char>('0' + digit);
+        --n;
+
+        auto const rest = (std::uint64_t{integral} << -one.e) + fractional;
+
+        if (rest <= delta)
+        {
+            decimal_exponent += n;
+
+            round_last_digit(digits,
+                             length,
+                             distance,
+                             delta,
+                             rest,
+                             std::uint64_t{power_of_ten} << -one.e);
+            return;
+        }
+    }
+
+    // The integral part is exhausted, so continue with the fractional digits
+    int m = 0;
+    do
+    {
+        fractional *= 10;
+
+        digits[length++] = static_cast<char>('0' + (fractional >> -one.e));
+        fractional &= one.f - 1;
+        ++m;
+
+        delta *= 10;
+        distance *= 10;
+    } while (fractional > delta);
+
+    decimal_exponent -= m;
+
+    round_last_digit(digits, length, distance, delta, fractional, one.f);
+}
+
+/// \return the number of characters for the digits d1 d2 ... dn * 10^e
+/// written as printf("%.17g") lays out a number
+int write_digits(char* buffer,
+                 char const* const digits,
+                 int const length,
+                 int const decimal_exponent) noexcept
+{
+    auto const start = buffer;
+
+    // Decimal exponent of the first digit
+    int const exponent = length + decimal_exponent - 1;
+
+    if (exponent < -4 || exponent >= 17)
+    {
+        *buffer++ = digits[0];
+
+        if (length > 1)
+        {
+            *buffer++ = '.';
+            buffer    = std::copy(digits + 1, digits + length, buffer);
+        }
+        *buffer++ = 'e';
+        *buffer++ = exponent < 0 ? '-' : '+';
+
+        auto const magnitude = exponent < 0 ? -exponent : exponent;
+
+        if (magnitude >= 100) *buffer++ = static_cast<char>('0' + magnitude / 100);
+
+        *buffer++ = static_cast<char>('0' + magnitude / 10 % 10);
+        *buffer++ = static_cast<char>('0' + magnitude % 10);
+    }
+    else if (decimal_exponent >= 0)
+    {
+        buffer = std::copy(digits, digits + length, buffer);
+        buffer = std::fill_n(buffer, decimal_exponent, '0');
+    }
+    else if (exponent >= 0)
+    {
+        buffer    = std::copy(digits, digits + exponent + 1, buffer);
+        *buffer++ = '.';
+        buffer    = std::copy(digits + exponent + 1, digits + length, buffer);
+    }
+    else
+    {
+        *buffer++ = '0';
+        *buffer++ = '.';
+        buffer    = std::fill_n(buffer, -exponent - 1, '0');
+        buffer    = std::copy(digits, digits + length, buffer);
+    }
+    return static_cast<int>(buffer - start);
+}
+
+template <typename Real, typename Bits>
+int format(Real const value, char* buffer) noexcept
+{
+    auto const start = buffer;
+
+    if (std::signbit(value)) *buffer++ = '-';
+
+    if (value == 0)
+    {
+        *buffer++ = '0';
+        return static_cast<int>(buffer - start);
+    }
+
+    auto const w = compute_boundaries<Real, Bits>(std::abs(value));
+
+    auto const& power = cached_power_for(w.plus.e);
+
+    diy_fp const scale{power.f, power.e};
+
+    // Shrink the scaled boundaries by one unit for the rounding error of the
+    // multiplication, so every digit string in between reads back exactly
+    auto const scaled_minus = multiply(w.minus, scale);
+    auto const scaled_plus  = multiply(w.plus, scale);
+
+    char digits[20];
+    int length           = 0;
+    int decimal_exponent = -power.k;
+
+    generate_digits(digits,
+                    length,
+                    decimal_exponent,
+                    {scaled_minus.f + 1, scaled_minus.e},
+                    multiply(w.w, scale),
+                    {scaled_plus.f - 1, scaled_plus.e});
+
+    buffer += write_digits(buffer, digits, length, decimal_exponent);
+
+    return static_cast<int>(buffer - start);
+}
+}
+
+int format_shortest(double const value, char* const buffer) noexcept
+{
+    return format<double, std::uint64_t>(value, buffer);
+}
+
+int format_shortest(float const value, char* const buffer) noexcept
+{
+    return format<float, std::uint32_t>(value, buffer);
+}
+
+int format_significant(double const value,
+                       int const significant_digits,
+                       char* const buffer) noexcept
+{
+    auto const length = std::snprintf(buffer,
+                                      real_buffer_size,
+                                      "%.*g",
+                                      significant_digits,
+                                      value);
+
+    // The decimal separator does not depend on the locale
+    std::replace(buffer, buffer + length, ',', '.');
+
+    return length;
+}
+} // namespace imr
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace imr
+{
+/// Size of a buffer holding any number written by the real number formatters
+constexpr int real_buffer_size = 32;
+
+/// Write decimal digits which read back as the same double (shortest in
+/// almost all cases), using the Grisu2 algorithm of Loitsch (2010) with exact
+/// integer arithmetic.  Grisu2 has no fallback, so a small fraction of the
+/// numbers get a digit more than necessary, e.g. 1e23 is written as
+/// 9.999999999999999e+22.  The number is written like printf("%.17g"), in
+/// fixed notation for decimal exponents from -5 to 16 and in scientific
+/// notation otherwise, e.g. 0.1 is written as 0.1 rather than
+/// 0.10000000000000001.
+/// \param value Finite number
+/// \param buffer Array of at least real_buffer_size characters
+/// \return the number of characters written, without a terminating null
+int format_shortest(double const value, char* const buffer) noexcept;
+
+/// Write decimal digits which read back as the same float (shortest in
+/// almost all cases)
+/// \sa format_shortest(double, char*)
+int format_shortest(float const value, char* const buffer) noexcept;
+
+/// Write the number rounded to a number of significant digits like
+/// printf("%.*g"), using a decimal point whatever the locale
+/// \param value Finite number
+/// \param significant_digits Number of significant digits from 1 to 17
+/// \param buffer Array of at least real_buffer_size characters
+/// \return the number of characters written, without a terminating null
+int format_significant(double const value,
+                       int const significant_digits,
+                       char* const buffer) noexcept;
+} // namespace imr
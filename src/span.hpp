@@ -0,0 +1,37 @@
+
+#pragma once
+
+#include <cstddef>
+
+namespace imr
+{
+/// Non-owning view over a contiguous sequence of objects
+template <typename T>
+class span
+{
+public:
+    using value_type = T;
+    using iterator   = T*;
+
+public:
+    constexpr span() noexcept = default;
+
+    constexpr span(T* data, std::size_t const size) noexcept : m_data(data), m_size(size) {}
+
+    constexpr T* data() const noexcept { return m_data; }
+
+    constexpr std::size_t size() const noexcept { return m_size; }
+
+    constexpr bool empty() const noexcept { return m_size == 0; }
+
+    constexpr T& operator[](std::size_t const i) const noexcept { return m_data[i]; }
+
+    constexpr T* begin() const noexcept { return m_data; }
+
+    constexpr T* end() const noexcept { return m_data + m_size; }
+
+private:
+    T* m_data          = nullptr;
+    std::size_t m_size = 0;
+};
+} // namespace imr
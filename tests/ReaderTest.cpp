@@ -1,11 +1,56 @@
 #define CATCH_CONFIG_MAIN
 
+#include "batch_scheduler.hpp"
+#include "block_compressor.hpp"
+#include "conversion_cache.hpp"
+#include "element_block.hpp"
+#include "element_traits.hpp"
+#include "file_watcher.hpp"
+#include "json_writer.hpp"
+#include "log.hpp"
+#include "memory_usage.hpp"
 #include "mesh_reader.hpp"
+#include "node_index.hpp"
+#include "node_merger.hpp"
+#include "parallel_for.hpp"
+#include "partition_metrics.hpp"
+#include "phase_timer.hpp"
+#include "real_format.hpp"
 
 #include <catch2/catch.hpp>
 
+#include <json/json.h>
+
+#ifdef IMR_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+
 using namespace imr;
 
+namespace
+{
+std::string read_file(std::string const& file_name)
+{
+    std::ifstream file(file_name);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+}
+
 TEST_CASE("Ensure exceptions are thrown")
 {
     SECTION("Throw a GmshReaderException for invalid mesh files")
@@ -69,6 +114,168 @@ TEST_CASE("Tests for decomposed ElementData")
     REQUIRE(elementData.isOwnedByProcess(3));
     REQUIRE(elementData.maxProcessId() == 4);
 }
+TEST_CASE("Monotonic arena")
+{
+    SECTION("Allocations are aligned")
+    {
+        monotonic_arena arena(64);
+
+        for (std::size_t const alignment : {1, 2, 4, 8, 16})
+        {
+            arena.allocate(1, 1);
+
+            auto const address = reinterpret_cast<std::uintptr_t>(arena.allocate(3, alignment));
+
+            REQUIRE(address % alignment == 0);
+        }
+    }
+    SECTION("Reset reuses the blocks")
+    {
+        monotonic_arena arena(1024);
+
+        auto const first = arena.allocate(8, 8);
+        for (auto i = 0; i < 300; ++i) arena.allocate(8, 8);
+
+        auto const blocks   = arena.blocks();
+        auto const capacity = arena.capacity();
+
+        REQUIRE(blocks == 3);
+
+        arena.reset();
+
+        REQUIRE(arena.allocate(8, 8) == first);
+        for (auto i = 0; i < 300; ++i) arena.allocate(8, 8);
+
+        REQUIRE(arena.blocks() == blocks);
+        REQUIRE(arena.capacity() == capacity);
+    }
+    SECTION("Requests larger than a block")
+    {
+        monotonic_arena arena(64);
+
+        arena.allocate(1000, 8);
+
+        REQUIRE(arena.blocks() == 1);
+        REQUIRE(arena.capacity() == 1000);
+
+        arena.allocate(8, 8);
+
+        REQUIRE(arena.blocks() == 2);
+        REQUIRE(arena.capacity() == 1064);
+    }
+    SECTION("Copied elements are allocated from the heap")
+    {
+        monotonic_arena arena;
+
+        std::vector<std::int64_t> const node_indices{402, 233, 450, 197};
+        std::vector<std::int32_t> const tags{3, 1, 2, -4};
+
+        element const original({node_indices.data(), node_indices.size()},
+                               {tags.data(), tags.size()},
+                               QUADRILATERAL4,
+                               1,
+                               arena);
+
+        REQUIRE(original.node_indices().get_allocator().arena() == &arena);
+
+        element const copy(original);
+
+        std::vector<std::int32_t> const partition_tags(begin(original.partitionTags()),
+                                                       end(original.partitionTags()));
+
+        REQUIRE(copy.node_indices().get_allocator().arena() == nullptr);
+        REQUIRE(copy.partitionTags().get_allocator().arena() == nullptr);
+
+        // Overwrite the memory of the original element
+        arena.reset();
+        std::memset(arena.allocate(arena.capacity(), 1), 0xff, arena.capacity());
+
+        REQUIRE(std::equal(begin(node_indices),
+                           end(node_indices),
+                           begin(copy.node_indices()),
+                           end(copy.node_indices())));
+        REQUIRE(std::equal(begin(partition_tags),
+                           end(partition_tags),
+                           begin(copy.partitionTags()),
+                           end(copy.partitionTags())));
+    }
+    SECTION("Arena elements are only accounted with the arena")
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+        // The group nodes of the map and the element arrays, while the node
+        // indices and the tags are in the single block of the arena
+        std::size_t expected = std::size_t{1} << 20;
+        for (auto const& group : reader.mesh())
+        {
+            expected += 32 + sizeof(group) + group.first.first.capacity() +
+                        group.second.capacity() * sizeof(element);
+
+            for (auto const& element_data : group.second)
+            {
+                REQUIRE(element_data.node_indices().get_allocator().arena() != nullptr);
+            }
+        }
+        REQUIRE(reader.memory().elements == expected);
+    }
+}
+TEST_CASE("Element type traits")
+{
+    static_assert(element_type<HEXAHEDRON8>::nodes == 8, "Compile-time node count");
+    static_assert(element_traits_of[TETRAHEDRON10].vertices == 4, "Compile-time vertices");
+
+    REQUIRE(nodes_per_element(TRIANGLE9) == 9);
+    REQUIRE(nodes_per_element(HEXAHEDRON125) == 125);
+    REQUIRE(element_dimension(POINT) == 0);
+    REQUIRE(element_dimension(PRISM15) == 3);
+
+    REQUIRE(element_traits_of[QUADRILATERAL8].order == 2);
+    REQUIRE(element_traits_of[HEXAHEDRON8].vtk_type == 12);
+
+    auto const& pyramid = element_traits_of[PYRAMID5].shape;
+
+    REQUIRE(pyramid.edges == 8);
+    REQUIRE(pyramid.faces == 5);
+    REQUIRE(pyramid.face_vertices[0][3] == -1);
+    REQUIRE(pyramid.face_vertices[4][3] == 1);
+
+    REQUIRE(visit_element_type(TETRAHEDRON4, [](auto const type) {
+                return decltype(type)::nodes;
+            }) == 4);
+
+    REQUIRE(!is_supported(32));
+    REQUIRE_THROWS_AS(nodes_per_element(32), std::domain_error);
+    REQUIRE_THROWS_AS(visit_element_type(0, [](auto) {}), std::domain_error);
+}
+TEST_CASE("Fixed-stride element blocks")
+{
+    element_block block(TRIANGLE3);
+
+    block.push_back(element({4, 5, 6}, {1, 1}, TRIANGLE3, 2));
+    block.push_back(element({7, 8, 9}, {1, 1}, TRIANGLE3, 3));
+
+    REQUIRE(block.stride() == 3);
+    REQUIRE(block.size() == 2);
+    REQUIRE(block.connectivity().size() == 6);
+    REQUIRE(block[1][0] == 7);
+    REQUIRE(block.ids()[1] == 3);
+
+    auto const rows = block.rows<TRIANGLE3>();
+
+    REQUIRE(rows.size() == 2);
+    REQUIRE(rows[0][2] == 6);
+    REQUIRE(rows[1][1] == 8);
+
+    for (auto& index : block.connectivity()) --index;
+
+    REQUIRE(block[0][0] == 3);
+
+    REQUIRE_THROWS_AS(block.push_back(element({1, 2, 3, 4}, {1, 1}, QUADRILATERAL4, 4)),
+                      std::domain_error);
+}
 TEST_CASE("Tests for Reader")
 {
     mesh_reader reader("decomposed.msh",
@@ -89,3 +296,1369 @@ TEST_CASE("Tests for Reader")
 
     reader.write(false);
 }
+TEST_CASE("Partition metrics")
+{
+    mesh_reader reader("decomposed.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti);
+
+    partition_metrics metrics(reader);
+
+    REQUIRE(metrics.partitions().size() == 4);
+
+    // Each partition owns a single quadrilateral touching every other partition
+    for (auto const& partition : metrics.partitions())
+    {
+        REQUIRE(partition.elements == 1);
+        REQUIRE(partition.weighted_elements == element_cost(4));
+        REQUIRE(partition.nodes == 4);
+        REQUIRE(partition.interface_nodes == 3);
+        REQUIRE(partition.neighbours == 3);
+        REQUIRE(partition.edge_cut == 3);
+    }
+    REQUIRE(metrics.element_imbalance() == Approx(1.0));
+    REQUIRE(metrics.node_imbalance() == Approx(1.0));
+    REQUIRE(metrics.interface_imbalance() == Approx(1.0));
+
+    SECTION("Out-of-core meshes are rejected")
+    {
+        mesh_reader out_of_core("decomposed.msh",
+                                NodalOrdering::Local,
+                                IndexingBase::Zero,
+                                distributed::feti,
+                                64);
+
+        REQUIRE(out_of_core.out_of_core());
+        REQUIRE_THROWS_AS(partition_metrics(out_of_core), std::domain_error);
+    }
+}
+TEST_CASE("Coincident node merging")
+{
+    SECTION("Stitched mesh")
+    {
+        mesh_reader reader("stitched.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti);
+
+        REQUIRE(reader.nodes().size() == 8);
+
+        REQUIRE(reader.merge_coincident_nodes(1.0e-6) == 2);
+
+        REQUIRE(reader.nodes().size() == 6);
+
+        auto const& elements = reader.mesh().begin()->second;
+
+        REQUIRE(elements[0].node_indices() == element::index_vector{1, 2, 3, 4});
+        REQUIRE(elements[1].node_indices() == element::index_vector{2, 5, 6, 3});
+    }
+    SECTION("Duplicated grid")
+    {
+        constexpr std::int64_t n = 200;
+
+        std::vector<node> nodes;
+        for (std::int64_t copy = 0; copy < 2; ++copy)
+        {
+            for (std::int64_t i = 0; i < n * n; ++i)
+            {
+                nodes.push_back({static_cast<std::int64_t>(nodes.size()) + 1,
+                                 {{(i % n) * 0.01 + copy * 1.0e-9, (i / n) * 0.01, 0.0}}});
+            }
+        }
+
+        auto const representative = find_coincident_nodes(nodes, 1.0e-6);
+
+        for (std::int64_t i = 0; i < n * n; ++i)
+        {
+            REQUIRE(representative[i] == i);
+            REQUIRE(representative[i + n * n] == i);
+        }
+    }
+    SECTION("Invalid tolerance")
+    {
+        REQUIRE_THROWS_AS(find_coincident_nodes({}, 0.0), std::domain_error);
+    }
+    SECTION("A missing node leaves the mesh unchanged")
+    {
+        // stitched.msh with the second element referring to the missing node 9
+        mesh_reader reader("stitched_missing_node.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti);
+
+        auto const nodes    = reader.nodes();
+        auto const elements = reader.mesh().begin()->second;
+
+        REQUIRE_THROWS_AS(reader.merge_coincident_nodes(1.0e-6), std::domain_error);
+
+        REQUIRE(reader.nodes().size() == nodes.size());
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            REQUIRE(reader.nodes()[i].id == nodes[i].id);
+        }
+        for (std::size_t i = 0; i < elements.size(); ++i)
+        {
+            REQUIRE(reader.mesh().begin()->second[i].node_indices() ==
+                    elements[i].node_indices());
+        }
+    }
+    SECTION("Exceptions thrown by the parallel loop reach the caller")
+    {
+        // Large enough for a chunk on every available thread
+        std::int64_t const size = std::int64_t{1} << 20;
+
+        REQUIRE_THROWS_AS(parallel_for(size,
+                                       [&](std::int64_t const, std::int64_t const last) {
+                                           if (last == size) throw std::domain_error("last");
+                                       }),
+                          std::domain_error);
+    }
+}
+TEST_CASE("Partitioned mesh assembled from split files")
+{
+    mesh_reader monolithic("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+    std::vector<std::string> const partition_files{"decomposed_1.msh",
+                                                   "decomposed_2.msh",
+                                                   "decomposed_3.msh",
+                                                   "decomposed_4.msh"};
+
+    mesh_reader reader(partition_files,
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti);
+
+    REQUIRE(reader.numberOfPartitions() == monolithic.numberOfPartitions());
+    REQUIRE(reader.names() == monolithic.names());
+    REQUIRE(reader.interfaces() == monolithic.interfaces());
+
+    REQUIRE(reader.nodes().size() == monolithic.nodes().size());
+    for (std::size_t i = 0; i < reader.nodes().size(); ++i)
+    {
+        REQUIRE(reader.nodes()[i].id == monolithic.nodes()[i].id);
+        REQUIRE(reader.nodes()[i].coordinates == monolithic.nodes()[i].coordinates);
+    }
+
+    // The ghost element in the first partition file is not duplicated
+    REQUIRE(reader.mesh().size() == monolithic.mesh().size());
+    for (auto const& mesh : monolithic.mesh())
+    {
+        auto const& elements = reader.mesh().at(mesh.first);
+
+        REQUIRE(elements.size() == mesh.second.size());
+        for (std::size_t i = 0; i < elements.size(); ++i)
+        {
+            REQUIRE(elements[i].id() == mesh.second[i].id());
+            REQUIRE(elements[i].node_indices() == mesh.second[i].node_indices());
+            REQUIRE(elements[i].partitionTags() == mesh.second[i].partitionTags());
+        }
+    }
+
+    REQUIRE_THROWS_AS(mesh_reader(std::vector<std::string>{},
+                                  NodalOrdering::Local,
+                                  IndexingBase::Zero,
+                                  distributed::feti),
+                      std::domain_error);
+
+    // decomposed_2.msh with the node 9 moved, which the other files share
+    REQUIRE_THROWS_AS(mesh_reader(std::vector<std::string>{"decomposed_1.msh",
+                                                           "moved_node_2.msh",
+                                                           "decomposed_3.msh",
+                                                           "decomposed_4.msh"},
+                                  NodalOrdering::Local,
+                                  IndexingBase::Zero,
+                                  distributed::feti),
+                      std::domain_error);
+}
+TEST_CASE("Out-of-core conversion")
+{
+    std::vector<std::string> in_core_outputs;
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+
+        for (auto partition = 0; partition < reader.numberOfPartitions(); ++partition)
+        {
+            in_core_outputs.push_back(read_file("decomposed.mesh" + std::to_string(partition)));
+        }
+    }
+
+    // A tiny budget spills every element as soon as it is parsed
+    mesh_reader reader("decomposed.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti,
+                       64);
+
+    REQUIRE(reader.numberOfPartitions() == 4);
+    REQUIRE(reader.mesh().empty());
+    REQUIRE(reader.nodes().empty());
+    REQUIRE_THROWS_AS(reader.merge_coincident_nodes(1.0e-6), std::domain_error);
+
+    reader.write(true);
+
+    for (auto partition = 0; partition < reader.numberOfPartitions(); ++partition)
+    {
+        REQUIRE(read_file("decomposed.mesh" + std::to_string(partition)) ==
+                in_core_outputs[partition]);
+    }
+}
+TEST_CASE("Streaming parser")
+{
+    // Accumulate the mesh size without storing the nodes or elements
+    class counter : public gmsh_visitor
+    {
+    public:
+        void physical_name(std::int32_t const /*dimension*/,
+                           std::int32_t const physical_id,
+                           std::string const& name) override
+        {
+            names.emplace(physical_id, name);
+        }
+
+        void nodes(span<node const> const batch) override
+        {
+            ++node_batches;
+            number_of_nodes += batch.size();
+        }
+
+        void elements(span<element_record const> const batch) override
+        {
+            for (auto const& record : batch)
+            {
+                ++number_of_elements;
+                number_of_indices += record.node_indices.size();
+                partitions = std::max<std::int32_t>(partitions, record.tags[3]);
+            }
+        }
+
+        std::map<std::int32_t, std::string> names;
+        std::int64_t node_batches = 0, number_of_nodes = 0;
+        std::int64_t number_of_elements = 0, number_of_indices = 0;
+        std::int32_t partitions = 0;
+    };
+
+    counter visitor;
+
+    // Use a small batch size to split the nodes into multiple batches
+    gmsh_parser(4).parse("decomposed.msh", visitor);
+
+    REQUIRE(visitor.names.at(1) == "domain");
+    REQUIRE(visitor.node_batches == 3);
+    REQUIRE(visitor.number_of_nodes == 9);
+    REQUIRE(visitor.number_of_elements == 4);
+    REQUIRE(visitor.number_of_indices == 16);
+    REQUIRE(visitor.partitions == 4);
+
+    REQUIRE_THROWS_AS(gmsh_parser().parse("invalid_file_name", visitor), std::domain_error);
+}
+TEST_CASE("Lazily parsed sections")
+{
+    SECTION("Section offsets")
+    {
+        gmsh_index const index("decomposed.msh");
+
+        REQUIRE(index.offset("$MeshFormat") == 0);
+        REQUIRE(index.offset("$EndMeshFormat") == 20);
+        REQUIRE(index.offset("$PhysicalNames") == 35);
+        REQUIRE(index.contains("$Nodes"));
+        REQUIRE(index.contains("$Elements"));
+        REQUIRE(!index.contains("$NodeData"));
+    }
+    SECTION("Elements are only parsed on access")
+    {
+        mesh_reader reader("unsupported_element.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti);
+
+        REQUIRE(reader.names().at(1) == "domain");
+        REQUIRE(reader.nodes().size() == 4);
+
+        REQUIRE_THROWS_AS(reader.mesh(), std::domain_error);
+    }
+    SECTION("Elements without tags are rejected")
+    {
+        mesh_reader reader("missing_tags.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti);
+
+        REQUIRE_THROWS_AS(reader.mesh(), std::domain_error);
+    }
+}
+TEST_CASE("Binary gmsh files")
+{
+    std::vector<std::string> outputs;
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+
+        for (auto partition = 0; partition < reader.numberOfPartitions(); ++partition)
+        {
+            auto const file_name = "decomposed.mesh" + std::to_string(partition);
+
+            outputs.push_back(read_file(file_name));
+            std::remove(file_name.c_str());
+        }
+    }
+
+    mesh_reader reader("decomposed_binary.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti);
+
+    REQUIRE(reader.numberOfPartitions() == 4);
+    REQUIRE(reader.names().at(1) == "domain");
+    REQUIRE(reader.nodes().size() == 9);
+
+    reader.write(true);
+
+    for (auto partition = 0; partition < reader.numberOfPartitions(); ++partition)
+    {
+        auto const file_name = "decomposed_binary.mesh" + std::to_string(partition);
+
+        REQUIRE(read_file(file_name) == outputs[partition]);
+        std::remove(file_name.c_str());
+    }
+}
+TEST_CASE("Index width and coordinate precision")
+{
+    std::vector<std::string> outputs;
+
+    for (auto const index_width : {0, 32, 64})
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+        output_format format;
+        format.index_width = index_width;
+        reader.set_output_format(format);
+
+        reader.write(true);
+
+        outputs.push_back(read_file("decomposed.mesh1"));
+    }
+    REQUIRE(outputs[0] == outputs[1]);
+    REQUIRE(outputs[0] == outputs[2]);
+
+    SECTION("The JSON layout matches Json::StyledWriter")
+    {
+        std::istringstream input(outputs[0]);
+        Json::Value document;
+        input >> document;
+
+        document["Values"].append(0.1);
+        document["Values"].append(-1.0e-300);
+        document["Values"].append("name");
+        document["Values"].append(Json::Value(Json::objectValue));
+        document["Long"].resize(30);
+        document["Empty"] = Json::Value(Json::arrayValue);
+
+        REQUIRE(json_writer(17).write(document) == Json::StyledWriter().write(document));
+    }
+    SECTION("Single precision coordinates")
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+        output_format format;
+        format.single_precision = true;
+        reader.set_output_format(format);
+
+        reader.write(true);
+
+        std::istringstream input(read_file("decomposed.mesh1"));
+        Json::Value document;
+        input >> document;
+
+        auto const x = document["Nodes"][0]["Coordinates"][1][0].asDouble();
+
+        REQUIRE(x == static_cast<double>(0.49999999999869399f));
+        REQUIRE(read_file("decomposed.mesh1").find("0.49999999999869399") == std::string::npos);
+    }
+
+    mesh_reader reader("decomposed.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti);
+
+    output_format format;
+    format.index_width = 16;
+
+    REQUIRE_THROWS_AS(reader.set_output_format(format), std::domain_error);
+}
+TEST_CASE("Compact output")
+{
+    auto const convert = [](bool const compact) {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+        output_format format;
+        format.compact = compact;
+        reader.set_output_format(format);
+
+        reader.write(true);
+
+        return read_file("decomposed.mesh1");
+    };
+
+    auto const styled  = convert(false);
+    auto const compact = convert(true);
+
+    REQUIRE(compact.size() < styled.size() / 2);
+    REQUIRE(std::count(begin(compact), end(compact), '\n') == 1);
+
+    Json::Value styled_document, compact_document;
+
+    std::istringstream(styled) >> styled_document;
+    std::istringstream(compact) >> compact_document;
+
+    // The flat arrays hold the rows of the nested arrays one after the other
+    auto const flatten = [](Json::Value const& rows) {
+        Json::Value values(Json::arrayValue);
+        for (auto const& row : rows)
+        {
+            for (auto const& value : row) values.append(value);
+        }
+        return values;
+    };
+
+    auto const& nodes = compact_document["Nodes"][0];
+
+    REQUIRE(nodes["Stride"].asInt() == 3);
+    REQUIRE(nodes["Coordinates"] == flatten(styled_document["Nodes"][0]["Coordinates"]));
+    REQUIRE(nodes["Indices"] == styled_document["Nodes"][0]["Indices"]);
+
+    auto const& elements = compact_document["Elements"];
+
+    REQUIRE(elements.size() == styled_document["Elements"].size());
+
+    for (Json::ArrayIndex group = 0; group < elements.size(); ++group)
+    {
+        auto const& styled_group = styled_document["Elements"][group];
+
+        REQUIRE(elements[group]["Stride"].asUInt() ==
+                styled_group["NodalConnectivity"][0].size());
+        REQUIRE(elements[group]["NodalConnectivity"] ==
+                flatten(styled_group["NodalConnectivity"]));
+        REQUIRE(elements[group]["Name"] == styled_group["Name"]);
+    }
+
+    REQUIRE(compact_document["Interface"] == styled_document["Interface"]);
+    REQUIRE(compact_document["LocalToGlobalMap"] == styled_document["LocalToGlobalMap"]);
+
+    for (int partition = 0; partition < 4; ++partition)
+    {
+        std::remove(("decomposed.mesh" + std::to_string(partition)).c_str());
+    }
+}
+#ifdef IMR_WITH_ZLIB
+/// \return the data of a gzip file made of one or more members
+std::string gunzip(std::string const& compressed)
+{
+    z_stream stream{};
+    inflateInit2(&stream, 15 + 16);
+
+    stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+
+    std::string data;
+    char buffer[1 << 14];
+
+    while (stream.avail_in > 0)
+    {
+        stream.next_out  = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        auto const status = inflate(&stream, Z_NO_FLUSH);
+        REQUIRE((status == Z_OK || status == Z_STREAM_END));
+
+        data.append(buffer, sizeof(buffer) - stream.avail_out);
+
+        // Continue with the next member
+        if (status == Z_STREAM_END) inflateReset(&stream);
+    }
+    inflateEnd(&stream);
+
+    return data;
+}
+
+TEST_CASE("Compressed output")
+{
+    SECTION("Independent blocks")
+    {
+        std::string data;
+        for (int i = 0; i < 40000; ++i) data += std::to_string(i * i) + ", ";
+
+        std::vector<std::string> blocks;
+
+        auto const compress_blocks = [&]() {
+            blocks.clear();
+
+            block_compressor compressor(compression::gzip,
+                                        [&](std::string const& block) { blocks.push_back(block); },
+                                        1 << 16);
+            compressor.write(data.data(), 1000);
+            compressor.write(data.data() + 1000, data.size() - 1000);
+            compressor.finish();
+
+            std::string compressed;
+            for (auto const& block : blocks) compressed += block;
+            return compressed;
+        };
+
+        auto const compressed = compress_blocks();
+
+        REQUIRE(blocks.size() == (data.size() + (1 << 16) - 1) / (1 << 16));
+        REQUIRE(compressed.size() < data.size() / 2);
+        REQUIRE(gunzip(compressed) == data);
+
+        // The output does not depend on the number of threads
+        thread_limit() = 1;
+        REQUIRE(compress_blocks() == compressed);
+        thread_limit() = 0;
+
+        REQUIRE(gunzip(compress(data, compression::gzip)) == data);
+
+        auto const empty = compress("", compression::gzip);
+
+        REQUIRE(!empty.empty());
+        REQUIRE(gunzip(empty).empty());
+    }
+    SECTION("Compressed partition files")
+    {
+        std::vector<std::string> outputs;
+
+        for (auto const method : {compression::none, compression::gzip})
+        {
+            mesh_reader reader("decomposed.msh",
+                               NodalOrdering::Local,
+                               IndexingBase::Zero,
+                               distributed::feti);
+
+            output_format format;
+            format.compress = method;
+            reader.set_output_format(format);
+
+            reader.write(false);
+
+            outputs.push_back(read_file("decomposed.mesh1" +
+                                        std::string(compression_suffix(method))));
+        }
+        REQUIRE(gunzip(outputs[1]) == outputs[0]);
+
+        for (int partition = 0; partition < 4; ++partition)
+        {
+            std::remove(("decomposed.mesh" + std::to_string(partition) + ".gz").c_str());
+        }
+    }
+}
+#endif
+TEST_CASE("Real number formatting")
+{
+    auto const shortest = [](auto const value) {
+        char buffer[real_buffer_size];
+        return std::string(buffer, format_shortest(value, buffer));
+    };
+
+    SECTION("Shortest digits in the printf layout")
+    {
+        REQUIRE(shortest(0.1) == "0.1");
+        REQUIRE(shortest(0.5000000000020591) == "0.5000000000020591");
+        REQUIRE(shortest(1.0) == "1");
+        REQUIRE(shortest(-0.0) == "-0");
+        REQUIRE(shortest(-2.5) == "-2.5");
+        REQUIRE(shortest(1.0e-4) == "0.0001");
+        REQUIRE(shortest(1.0e-5) == "1e-05");
+        REQUIRE(shortest(1.0e16) == "10000000000000000");
+        REQUIRE(shortest(1.5e17) == "1.5e+17");
+        REQUIRE(shortest(5.0e-324) == "5e-324");
+        REQUIRE(shortest(std::numeric_limits<double>::max()) == "1.7976931348623157e+308");
+        REQUIRE(shortest(0.3f) == "0.3");
+        REQUIRE(shortest(std::numeric_limits<float>::max()) == "3.4028235e+38");
+        REQUIRE(shortest(std::numeric_limits<float>::denorm_min()) == "1e-45");
+    }
+    SECTION("Random numbers read back exactly")
+    {
+        std::mt19937_64 generator(42);
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            auto const bits = generator();
+
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+
+            if (!std::isfinite(value)) continue;
+
+            auto const written = shortest(value);
+
+            REQUIRE(std::strtod(written.c_str(), nullptr) == value);
+
+            char printed[real_buffer_size];
+            auto const printed_length = std::snprintf(printed, sizeof(printed), "%.17g", value);
+
+            REQUIRE(written.size() <= static_cast<std::size_t>(printed_length));
+
+            auto const single_bits = static_cast<std::uint32_t>(bits);
+
+            float single;
+            std::memcpy(&single, &single_bits, sizeof(single));
+
+            if (!std::isfinite(single)) continue;
+
+            REQUIRE(std::strtof(shortest(single).c_str(), nullptr) == single);
+        }
+    }
+    SECTION("Fixed significant digits")
+    {
+        char buffer[real_buffer_size];
+
+        REQUIRE(std::string(buffer, format_significant(0.1, 17, buffer)) == "0.10000000000000001");
+        REQUIRE(std::string(buffer, format_significant(2.0 / 3.0, 3, buffer)) == "0.667");
+
+        Json::Value document;
+        document.append(0.1);
+
+        REQUIRE(json_writer().write(document) == "[ 0.1 ]\n");
+        REQUIRE(json_writer(17).write(document) == "[ 0.10000000000000001 ]\n");
+        REQUIRE(json_writer(0, true).write(document) == "[ 0.1 ]\n");
+    }
+}
+TEST_CASE("Sparse node ids")
+{
+    SECTION("Node index")
+    {
+        node_index index;
+
+        for (auto const id : {5, 6, 7}) index.append(id);
+
+        REQUIRE(index.contiguous());
+        REQUIRE(index.position(7) == 2);
+        REQUIRE(index.memory_bytes() == 0);
+
+        for (auto const id : {100, 3, 1000000000}) index.append(id);
+
+        REQUIRE(!index.contiguous());
+        REQUIRE(index.size() == 6);
+        REQUIRE(index.max_id() == 1000000000);
+        REQUIRE(index.position(6) == 1);
+        REQUIRE(index.position(3) == 4);
+        REQUIRE(index.position(1000000000) == 5);
+        REQUIRE(!index.contains(8));
+        REQUIRE_THROWS_AS(index.position(4), std::domain_error);
+
+        index.clear();
+        index.append(1);
+
+        REQUIRE(index.contiguous());
+        REQUIRE(index.position(1) == 0);
+    }
+    SECTION("Conversion with gaps in the node numbering")
+    {
+        std::string original;
+        {
+            mesh_reader reader("basic.msh",
+                               NodalOrdering::Local,
+                               IndexingBase::One,
+                               distributed::feti);
+            reader.write(false);
+            original = read_file("basic.mesh");
+        }
+
+        // basic.msh with the node ids mapped to 3 * id + 5 and the nodes in
+        // reverse order
+        mesh_reader reader("sparse.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::One,
+                           distributed::feti);
+
+        REQUIRE(reader.nodes().front().id == 3 * 121 + 5);
+
+        reader.write(false);
+
+        REQUIRE(read_file("sparse.mesh") == original);
+
+        std::remove("sparse.mesh");
+    }
+    SECTION("Out-of-core conversion with gaps in the node numbering")
+    {
+        std::string original;
+        {
+            mesh_reader reader("sparse.msh",
+                               NodalOrdering::Local,
+                               IndexingBase::One,
+                               distributed::feti);
+            reader.write(false);
+            original = read_file("sparse.mesh");
+        }
+
+        // The spilled nodes are stored in parse order rather than by id
+        mesh_reader reader("sparse.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::One,
+                           distributed::feti,
+                           64);
+
+        REQUIRE(reader.nodes().empty());
+
+        reader.write(false);
+
+        REQUIRE(read_file("sparse.mesh") == original);
+
+        std::remove("sparse.mesh");
+    }
+    SECTION("Elements referring to a missing node")
+    {
+        // basic.msh without the node 61
+        mesh_reader in_core("missing_node.msh",
+                            NodalOrdering::Local,
+                            IndexingBase::One,
+                            distributed::feti);
+
+        REQUIRE_THROWS_AS(in_core.write(false), std::domain_error);
+
+        mesh_reader out_of_core("missing_node.msh",
+                                NodalOrdering::Local,
+                                IndexingBase::One,
+                                distributed::feti,
+                                64);
+
+        REQUIRE_THROWS_AS(out_of_core.write(false), std::domain_error);
+
+        std::remove("missing_node.mesh");
+    }
+}
+TEST_CASE("Physical group resolution")
+{
+    std::string original;
+    {
+        mesh_reader reader("basic.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::One,
+                           distributed::feti);
+        reader.write(false);
+        original = read_file("basic.mesh");
+    }
+
+    // basic.msh with the left boundary moved to a physical id outside of the
+    // dense group table
+    mesh_reader reader("large_physical_id.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::One,
+                       distributed::feti);
+
+    REQUIRE(reader.names().at(1000000) == "left_boundary");
+    REQUIRE(reader.mesh().count({"left_boundary", LINE2}) == 1);
+
+    reader.write(false);
+
+    REQUIRE(read_file("large_physical_id.mesh") == original);
+
+    std::remove("large_physical_id.mesh");
+}
+TEST_CASE("Filtered conversion")
+{
+    SECTION("Physical group filter")
+    {
+        element_filter filter;
+        filter.physical_names = {"left_boundary"};
+
+        mesh_reader reader("basic.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti,
+                           filter);
+
+        REQUIRE(reader.mesh().size() == 1);
+        REQUIRE(reader.mesh().begin()->first.first == "left_boundary");
+        REQUIRE(reader.mesh().begin()->second.size() == 10);
+
+        reader.write(false);
+
+        // Only the nodes on the boundary line are written
+        std::ifstream output("basic.mesh");
+        Json::Value mesh;
+        output >> mesh;
+
+        REQUIRE(mesh["Nodes"][0]["Coordinates"].size() == 11);
+    }
+    SECTION("Dimension filter")
+    {
+        element_filter filter;
+        filter.dimensions = {2};
+
+        mesh_reader reader("basic.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti,
+                           filter);
+
+        REQUIRE(reader.mesh().size() == 1);
+        REQUIRE(reader.mesh().begin()->first.first == "domain");
+        REQUIRE(reader.mesh().begin()->second.size() == 200);
+    }
+    SECTION("Partitions are counted for skipped elements")
+    {
+        element_filter filter;
+        filter.dimensions = {3};
+
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Global,
+                           IndexingBase::One,
+                           distributed::feti,
+                           filter);
+
+        REQUIRE(reader.mesh().empty());
+        REQUIRE(reader.interfaces().empty());
+        REQUIRE(reader.numberOfPartitions() == 4);
+    }
+    SECTION("Unknown physical groups and dimensions are rejected")
+    {
+        element_filter unknown_name;
+        unknown_name.physical_names = {"domain", "nosuch"};
+
+        element_filter unknown_dimension;
+        unknown_dimension.dimensions = {4};
+
+        for (auto const& filter : {unknown_name, unknown_dimension})
+        {
+            mesh_reader reader("basic.msh",
+                               NodalOrdering::Global,
+                               IndexingBase::One,
+                               distributed::feti,
+                               filter);
+
+            REQUIRE_THROWS_AS(reader.mesh(), std::domain_error);
+
+            REQUIRE_THROWS_AS(mesh_reader("basic.msh",
+                                          NodalOrdering::Global,
+                                          IndexingBase::One,
+                                          distributed::feti,
+                                          64,
+                                          filter),
+                              std::domain_error);
+        }
+    }
+}
+TEST_CASE("Selective partition extraction")
+{
+    std::vector<std::string> outputs;
+    {
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+
+        for (auto partition = 0; partition < reader.numberOfPartitions(); ++partition)
+        {
+            auto const file_name = "decomposed.mesh" + std::to_string(partition);
+
+            outputs.push_back(read_file(file_name));
+            std::remove(file_name.c_str());
+        }
+    }
+
+    element_filter filter;
+    filter.first_partition = 1;
+    filter.last_partition  = 2;
+
+    mesh_reader reader("decomposed.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti,
+                       filter);
+
+    REQUIRE(reader.numberOfPartitions() == 4);
+
+    // Only the elements owned by the partitions in the range are stored
+    REQUIRE(reader.mesh().begin()->second.size() == 2);
+
+    reader.write(true);
+
+    REQUIRE(!std::ifstream("decomposed.mesh0").is_open());
+    REQUIRE(read_file("decomposed.mesh1") == outputs[1]);
+    REQUIRE(read_file("decomposed.mesh2") == outputs[2]);
+    REQUIRE(!std::ifstream("decomposed.mesh3").is_open());
+
+    std::remove("decomposed.mesh1");
+    std::remove("decomposed.mesh2");
+
+    // A range beyond the partitions of the mesh writes nothing
+    filter.first_partition = 4;
+    filter.last_partition  = 6;
+
+    mesh_reader outside("decomposed.msh",
+                        NodalOrdering::Local,
+                        IndexingBase::Zero,
+                        distributed::feti,
+                        filter);
+
+    std::ostringstream log;
+    {
+        scoped_log const redirect(log);
+        outside.write(true);
+    }
+    REQUIRE(log.str().find("Warning: the partition range") != std::string::npos);
+
+    for (auto partition = 0; partition < 4; ++partition)
+    {
+        REQUIRE(!std::ifstream("decomposed.mesh" + std::to_string(partition)).is_open());
+    }
+}
+
+TEST_CASE("Batch conversion")
+{
+    std::vector<std::string> const input_files{"decomposed.msh", "basic.msh", "stitched.msh"};
+
+    // Only the decomposed mesh has a partition suffix
+    std::vector<std::string> const output_files{"decomposed.mesh0", "basic.mesh", "stitched.mesh"};
+
+    std::vector<std::string> outputs;
+    for (std::size_t i = 0; i < input_files.size(); ++i)
+    {
+        mesh_reader reader(input_files[i],
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+        outputs.push_back(read_file(output_files[i]));
+        std::remove(output_files[i].c_str());
+    }
+
+    SECTION("Outputs and logs do not depend on the schedule")
+    {
+        // A budget fitting a single file at a time and one with room for all
+        for (auto const memory_budget : {std::size_t{1}, std::size_t{1} << 30})
+        {
+            batch_scheduler scheduler(memory_budget, 4);
+
+            std::ostringstream log;
+
+            std::atomic<bool> within_limits{true};
+
+            scheduler.run(input_files,
+                          [&](std::string const& input, std::size_t const memory) {
+                              if (memory == 0 || thread_limit() < 1 || thread_limit() > 4)
+                              {
+                                  within_limits = false;
+                              }
+
+                              log_stream() << input << "\n";
+
+                              mesh_reader reader(input,
+                                                 NodalOrdering::Local,
+                                                 IndexingBase::Zero,
+                                                 distributed::feti);
+                              reader.write(true);
+
+                              log_stream() << input << " done\n";
+                          },
+                          log);
+
+            REQUIRE(within_limits);
+
+            std::string expected;
+            for (auto const& input : input_files) expected += input + "\n" + input + " done\n";
+
+            // The progress messages of the readers are in between
+            std::istringstream lines(log.str());
+            std::string filtered;
+            for (std::string line; std::getline(lines, line);)
+            {
+                if (line.find(".msh") != std::string::npos) filtered += line + "\n";
+            }
+            REQUIRE(filtered == expected);
+
+            for (std::size_t i = 0; i < input_files.size(); ++i)
+            {
+                REQUIRE(read_file(output_files[i]) == outputs[i]);
+            }
+        }
+    }
+    SECTION("The first failure is rethrown after every conversion")
+    {
+        batch_scheduler scheduler(std::size_t{1} << 30, 2);
+
+        std::vector<std::string> converted;
+        std::mutex mutex;
+
+        REQUIRE_THROWS_AS(scheduler.run({"invalid_file_name", "basic.msh"},
+                                        [&](std::string const& input, std::size_t) {
+                                            mesh_reader reader(input,
+                                                               NodalOrdering::Global,
+                                                               IndexingBase::One,
+                                                               distributed::feti);
+                                            std::lock_guard<std::mutex> lock(mutex);
+                                            converted.push_back(input);
+                                        },
+                                        std::cout),
+                          std::domain_error);
+
+        REQUIRE(converted == std::vector<std::string>{"basic.msh"});
+    }
+}
+
+TEST_CASE("Conversion cache")
+{
+    SECTION("Hash does not depend on the updates")
+    {
+        std::string const content = read_file("decomposed.msh");
+
+        content_hash whole, pieces;
+        whole.update(content);
+
+        for (std::size_t first = 0; first < content.size(); first += 13)
+        {
+            auto const size = std::min<std::size_t>(13, content.size() - first);
+            pieces.update(content.data() + first, size);
+        }
+        REQUIRE(whole.digest() == pieces.digest());
+        REQUIRE(hash_file("decomposed.msh") == whole.digest());
+        REQUIRE(hash_file("basic.msh") != whole.digest());
+    }
+    SECTION("Unchanged conversions are skipped")
+    {
+        std::remove("decomposed.manifest.json");
+
+        {
+            conversion_cache cache("decomposed.msh", "zero-based=1;");
+            REQUIRE(!cache.up_to_date());
+
+            mesh_reader reader("decomposed.msh",
+                               NodalOrdering::Local,
+                               IndexingBase::Zero,
+                               distributed::feti);
+            reader.write(true, &cache);
+            cache.save();
+        }
+
+        REQUIRE(conversion_cache("decomposed.msh", "zero-based=1;").up_to_date());
+        REQUIRE(!conversion_cache("decomposed.msh", "zero-based=0;").up_to_date());
+
+        std::remove("decomposed.mesh2");
+        REQUIRE(!conversion_cache("decomposed.msh", "zero-based=1;").up_to_date());
+    }
+    SECTION("Only changed outputs are written")
+    {
+        std::remove("basic.manifest.json");
+        {
+            conversion_cache cache("basic.msh", "");
+            REQUIRE(cache.write("basic.cached", "first"));
+            cache.save();
+        }
+        conversion_cache cache("basic.msh", "");
+        REQUIRE(!cache.write("basic.cached", "first"));
+        REQUIRE(cache.write("basic.cached", "second"));
+        REQUIRE(read_file("basic.cached") == "second");
+
+        std::remove("basic.cached");
+        std::remove("basic.manifest.json");
+    }
+}
+
+TEST_CASE("Watch mode")
+{
+    auto const copy_file = [](std::string const& from, std::string const& to) {
+        std::ofstream(to) << read_file(from);
+    };
+
+    SECTION("Reloaded meshes match a new reader")
+    {
+        copy_file("basic.msh", "watched.msh");
+
+        mesh_reader reader("watched.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+
+        REQUIRE(reader.numberOfPartitions() == 1);
+
+        copy_file("decomposed.msh", "watched.msh");
+        reader.reload();
+
+        mesh_reader const expected("watched.msh",
+                                   NodalOrdering::Local,
+                                   IndexingBase::Zero,
+                                   distributed::feti);
+
+        REQUIRE(reader.numberOfPartitions() == expected.numberOfPartitions());
+        REQUIRE(reader.nodes().size() == expected.nodes().size());
+        REQUIRE(reader.mesh().size() == expected.mesh().size());
+
+        for (auto const& mesh : expected.mesh())
+        {
+            REQUIRE(reader.mesh().at(mesh.first).size() == mesh.second.size());
+        }
+
+        std::remove("watched.msh");
+    }
+    SECTION("Reloading a copy keeps the elements of the original")
+    {
+        copy_file("basic.msh", "watched.msh");
+
+        mesh_reader reader("watched.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.mesh();
+
+        // The copy shares the arena the elements of the original are stored in
+        auto copy = reader;
+
+        copy_file("decomposed.msh", "watched.msh");
+        copy.reload();
+        copy.mesh();
+
+        mesh_reader const expected("basic.msh",
+                                   NodalOrdering::Local,
+                                   IndexingBase::Zero,
+                                   distributed::feti);
+
+        for (auto const& mesh : expected.mesh())
+        {
+            auto const& elements = reader.mesh().at(mesh.first);
+
+            REQUIRE(elements.size() == mesh.second.size());
+
+            for (std::size_t i = 0; i < elements.size(); ++i)
+            {
+                REQUIRE(elements[i].node_indices() == mesh.second[i].node_indices());
+            }
+        }
+
+        std::remove("watched.msh");
+    }
+    SECTION("Out-of-core readers cannot be reloaded")
+    {
+        mesh_reader reader("basic.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti,
+                           std::size_t{1} << 20);
+
+        REQUIRE_THROWS_AS(reader.reload(), std::domain_error);
+    }
+    SECTION("Changes to the watched files are reported")
+    {
+        copy_file("basic.msh", "watched_first.msh");
+        copy_file("basic.msh", "watched_second.msh");
+
+        file_watcher watcher({"watched_first.msh", "watched_second.msh"});
+
+        std::thread writer([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            // Replace the file by moving a new one over it
+            copy_file("decomposed.msh", "watched_second.msh.tmp");
+            std::rename("watched_second.msh.tmp", "watched_second.msh");
+        });
+
+        auto const changed = watcher.wait(50);
+
+        writer.join();
+
+        REQUIRE(changed == std::vector<std::string>{"watched_second.msh"});
+
+        std::remove("watched_first.msh");
+        std::remove("watched_second.msh");
+    }
+}
+
+TEST_CASE("Phase timers")
+{
+    reset_timers();
+
+    SECTION("Disabled timers record nothing")
+    {
+        {
+            scoped_timer const timer("disabled");
+        }
+        REQUIRE(recorded_timings().empty());
+    }
+    SECTION("Nested phases are aggregated per partition and thread")
+    {
+        enable_timers();
+
+        for (auto partition = 0; partition < 2; ++partition)
+        {
+            scoped_timer const outer("outer", partition);
+            scoped_timer const inner("inner");
+        }
+
+        std::thread([]() { scoped_timer const outer("outer", 0); }).join();
+
+        mesh_reader reader("decomposed.msh",
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+
+        enable_timers(false);
+
+        auto const timings = recorded_timings();
+
+        std::vector<std::string> phases;
+        for (auto const& timing : timings)
+        {
+            if (phases.empty() || phases.back() != timing.phase) phases.push_back(timing.phase);
+        }
+        REQUIRE(phases.front() == "outer");
+        REQUIRE(phases.at(1) == "outer/inner");
+        REQUIRE(std::count(begin(phases), end(phases), "write partition/serialise") == 1);
+
+        // Two partitions on the first thread and one partition on another
+        REQUIRE(timings.at(0).partition == 0);
+        REQUIRE(timings.at(1).partition == 0);
+        REQUIRE(timings.at(1).thread != timings.at(0).thread);
+        REQUIRE(timings.at(2).partition == 1);
+        REQUIRE(timings.at(2).thread == timings.at(0).thread);
+
+        // The inner phases inherit the partition of the outer phase
+        REQUIRE(timings.at(3).phase == "outer/inner");
+        REQUIRE(timings.at(3).partition == 0);
+        REQUIRE(timings.at(4).partition == 1);
+
+        std::ostringstream table;
+        print_timings(table);
+        REQUIRE(table.str().find("    serialise") != std::string::npos);
+    }
+    reset_timers();
+}
+
+TEST_CASE("Trace events")
+{
+    reset_timers();
+    enable_timers();
+
+    SECTION("Events are only recorded when tracing")
+    {
+        {
+            scoped_timer const timer("untraced");
+        }
+        write_trace("untraced.json");
+
+        Json::Value trace;
+        std::ifstream trace_file("untraced.json");
+        REQUIRE(Json::Reader().parse(trace_file, trace, false));
+        REQUIRE(trace["traceEvents"].size() == 0);
+
+        std::remove("untraced.json");
+    }
+    SECTION("Each phase is a complete event on its thread")
+    {
+        enable_tracing();
+
+        mesh_reader reader(std::vector<std::string>{"decomposed_1.msh",
+                                                    "decomposed_2.msh",
+                                                    "decomposed_3.msh",
+                                                    "decomposed_4.msh"},
+                           NodalOrdering::Local,
+                           IndexingBase::Zero,
+                           distributed::feti);
+        reader.write(true);
+
+        enable_tracing(false);
+
+        write_trace("trace.json");
+
+        Json::Value trace;
+        std::ifstream trace_file("trace.json");
+        REQUIRE(Json::Reader().parse(trace_file, trace, false));
+
+        std::set<int> fragments, partitions;
+
+        for (auto const& event : trace["traceEvents"])
+        {
+            REQUIRE(event["ph"].asString() == "X");
+            REQUIRE(event["ts"].asDouble() >= 0.0);
+            REQUIRE(event["dur"].asDouble() >= 0.0);
+            REQUIRE(event.isMember("tid"));
+
+            if (event["name"].asString() == "parse fragment")
+            {
+                fragments.insert(event["args"]["partition"].asInt());
+            }
+            else if (event["name"].asString() == "write partition")
+            {
+                partitions.insert(event["args"]["partition"].asInt());
+            }
+        }
+        REQUIRE(fragments == std::set<int>{0, 1, 2, 3});
+        REQUIRE(partitions == std::set<int>{0, 1, 2, 3});
+
+        std::remove("trace.json");
+    }
+    enable_timers(false);
+    reset_timers();
+}
+
+TEST_CASE("Memory accounting")
+{
+    auto const resident = read_resident_memory();
+
+    REQUIRE(resident.current > 0);
+    REQUIRE(resident.peak >= resident.current);
+
+    mesh_reader reader("decomposed.msh",
+                       NodalOrdering::Local,
+                       IndexingBase::Zero,
+                       distributed::feti);
+
+    SECTION("Partition copies are only accounted when enabled")
+    {
+        reader.write(true);
+
+        auto const usage = reader.memory();
+
+        REQUIRE(usage.nodes == reader.nodes().capacity() * sizeof(node));
+        REQUIRE(usage.elements > 0);
+        REQUIRE(usage.interfaces > 0);
+        REQUIRE(usage.partition_elements == 0);
+        REQUIRE(usage.json_document == 0);
+    }
+    SECTION("Peak resident memory is recorded for each phase")
+    {
+        reset_timers();
+        enable_timers();
+        enable_memory_accounting();
+
+        reader.write(true);
+
+        enable_memory_accounting(false);
+        enable_timers(false);
+
+        auto const usage = reader.memory();
+
+        REQUIRE(usage.partition_elements > 0);
+        REQUIRE(usage.json_document > usage.partition_elements);
+
+        for (auto const& timing : recorded_timings())
+        {
+            REQUIRE(timing.peak_resident_bytes > 0);
+        }
+        reset_timers();
+
+        std::ostringstream breakdown;
+        usage.print(breakdown);
+        REQUIRE(breakdown.str().find("Largest JSON document") != std::string::npos);
+    }
+}